@@ -17,69 +17,36 @@
 
 #include "CacheEntry.hpp"
 #include <gst/gst.h>
-#include <config.h>
 
 #define GST_CAT_DEFAULT kurento_cache_entry
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 #define GST_DEFAULT_NAME "KurentoCacheEntry"
 
-using namespace Glib::Threads;
-
-/* Next stuff is included to avoid problems with slots and lamdas */
-#include <type_traits>
-#include <sigc++/sigc++.h>
-#include <event2/event_struct.h>
-#if FIX_SIGC
-namespace sigc
-{
-template <typename Functor>
-struct functor_trait<Functor, false> {
-  typedef decltype (::sigc::mem_fun (std::declval<Functor &> (),
-                                     &Functor::operator() ) ) _intermediate;
-
-  typedef typename _intermediate::result_type result_type;
-  typedef Functor functor_type;
-};
-}
-#endif
-
 namespace kurento
 {
 
-CacheEntry::CacheEntry (unsigned int timeout, std::string sessionId,
-                        std::string requestId, Json::Value &response)
+CacheEntry::CacheEntry (const std::string &sessionId,
+                        const std::string &requestId, const std::string &response,
+                        const std::string &responseSessionId) :
+  sessionId (sessionId), requestId (requestId), response (response),
+  responseSessionId (responseSessionId)
 {
-  this->response = response;
-  this->requestId = requestId;
-  this->sessionId = sessionId;
-
-  source = Glib::TimeoutSource::create (timeout);
-  source->connect ( [this] () -> bool {
-    std::unique_lock<std::recursive_mutex> lock (mutex);
-    this->timedout = true;
-    lock.unlock();
-
-    this->signalTimeout.emit();
-
-    return false;
-  });
-
-  source->attach();
 }
 
-Json::Value &
-CacheEntry::getResponse (void)
+const std::string &
+CacheEntry::getResponse (void) const
 {
   return response;
 }
 
-CacheEntry::~CacheEntry ()
+const std::string &
+CacheEntry::getResponseSessionId (void) const
 {
-  std::unique_lock<std::recursive_mutex> lock (mutex);
+  return responseSessionId;
+}
 
-  if (!timedout) {
-    source->destroy();
-  }
+CacheEntry::~CacheEntry ()
+{
 }
 
 CacheEntry::StaticConstructor CacheEntry::staticConstructor;
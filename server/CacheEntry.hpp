@@ -18,32 +18,29 @@
 #ifndef __CACHE_ENTRY_H__
 #define __CACHE_ENTRY_H__
 
-#include <glibmm.h>
-#include <mutex>
-
-#include <json/json.h>
+#include <string>
 
 namespace kurento
 {
 
+/**
+ * Immutable cached response, stored already serialized so it can be sent
+ * again without building or writing any JSON.
+ */
 class CacheEntry
 {
 public:
-  CacheEntry (unsigned int timeout, std::string sessionId, std::string requestId,
-              Json::Value &response);
-  Json::Value &getResponse (void);
+  CacheEntry (const std::string &sessionId, const std::string &requestId,
+              const std::string &response, const std::string &responseSessionId);
+  const std::string &getResponse (void) const;
+  const std::string &getResponseSessionId (void) const;
   ~CacheEntry ();
 
-  sigc::signal<void> signalTimeout;
-
-
 private:
-  Glib::RefPtr<Glib::TimeoutSource> source;
-  std::recursive_mutex mutex;
-  std::string sessionId;
-  std::string requestId;
-  Json::Value response;
-  bool timedout = false;
+  const std::string sessionId;
+  const std::string requestId;
+  const std::string response;
+  const std::string responseSessionId;
 
   class StaticConstructor
   {
@@ -0,0 +1,198 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "Metrics.hpp"
+
+#include <algorithm>
+
+namespace kurento
+{
+
+const unsigned int Histogram::BUCKETS;
+
+static std::atomic<unsigned int> nextShard (0);
+
+static unsigned int
+getShard ()
+{
+  static thread_local unsigned int shard = nextShard++ % METRIC_SHARDS;
+
+  return shard;
+}
+
+Counter::Counter ()
+{
+  for (Shard &shard : shards) {
+    shard.value = 0;
+  }
+}
+
+void
+Counter::add (uint64_t n)
+{
+  shards[getShard ()].value.fetch_add (n, std::memory_order_relaxed);
+}
+
+uint64_t
+Counter::get () const
+{
+  uint64_t value = 0;
+
+  for (const Shard &shard : shards) {
+    value += shard.value.load (std::memory_order_relaxed);
+  }
+
+  return value;
+}
+
+Histogram::Histogram ()
+{
+  for (Shard &shard : shards) {
+    shard.count = 0;
+    shard.sum = 0;
+    shard.max = 0;
+
+    for (std::atomic<uint64_t> &bucket : shard.buckets) {
+      bucket = 0;
+    }
+  }
+}
+
+unsigned int
+Histogram::getBucket (uint64_t value)
+{
+  unsigned int exponent;
+  unsigned int bucket;
+
+  if (value < 8) {
+    return value;
+  }
+
+  exponent = 63 - __builtin_clzll (value);
+  bucket = 8 + (exponent - 3) * 8 + ( (value >> (exponent - 3) ) & 7);
+
+  return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+uint64_t
+Histogram::getBucketMax (unsigned int bucket)
+{
+  unsigned int exponent;
+  uint64_t first;
+
+  if (bucket < 8) {
+    return bucket;
+  }
+
+  if (bucket >= BUCKETS - 1) {
+    return UINT64_MAX;
+  }
+
+  exponent = (bucket - 8) / 8 + 3;
+  first = (uint64_t) (8 + (bucket - 8) % 8) << (exponent - 3);
+
+  return first + ( (uint64_t) 1 << (exponent - 3) ) - 1;
+}
+
+void
+Histogram::record (uint64_t value)
+{
+  Shard &shard = shards[getShard ()];
+  uint64_t max = shard.max.load (std::memory_order_relaxed);
+
+  shard.count.fetch_add (1, std::memory_order_relaxed);
+  shard.sum.fetch_add (value, std::memory_order_relaxed);
+  shard.buckets[getBucket (value)].fetch_add (1, std::memory_order_relaxed);
+
+  while (value > max && !shard.max.compare_exchange_weak (max, value,
+         std::memory_order_relaxed) ) {
+  }
+}
+
+void
+Histogram::recordSince (Clock::time_point start)
+{
+  record (std::chrono::duration_cast<std::chrono::microseconds>
+          (Clock::now () - start).count () );
+}
+
+Histogram::Snapshot
+Histogram::getSnapshot () const
+{
+  Snapshot snapshot;
+
+  /* Shards are read one by one, a snapshot is not an atomic view */
+  for (const Shard &shard : shards) {
+    snapshot.count += shard.count.load (std::memory_order_relaxed);
+    snapshot.sum += shard.sum.load (std::memory_order_relaxed);
+    snapshot.max = std::max (snapshot.max,
+                             shard.max.load (std::memory_order_relaxed) );
+
+    for (unsigned int i = 0; i < BUCKETS; i++) {
+      snapshot.buckets[i] += shard.buckets[i].load (std::memory_order_relaxed);
+    }
+  }
+
+  return snapshot;
+}
+
+double
+Histogram::Snapshot::mean () const
+{
+  return count > 0 ? (double) sum / count : 0;
+}
+
+uint64_t
+Histogram::Snapshot::percentile (double p) const
+{
+  uint64_t total = 0;
+  uint64_t target;
+
+  for (uint64_t bucket : buckets) {
+    total += bucket;
+  }
+
+  if (total == 0) {
+    return 0;
+  }
+
+  target = std::max<uint64_t> (1, (uint64_t) (p * total + 0.5) );
+
+  for (unsigned int i = 0; i < BUCKETS; i++) {
+    if (buckets[i] >= target) {
+      return std::min (getBucketMax (i), max);
+    }
+
+    target -= buckets[i];
+  }
+
+  return max;
+}
+
+void
+Histogram::Snapshot::merge (const Snapshot &other)
+{
+  count += other.count;
+  sum += other.sum;
+  max = std::max (max, other.max);
+
+  for (unsigned int i = 0; i < BUCKETS; i++) {
+    buckets[i] += other.buckets[i];
+  }
+}
+
+} /* kurento */
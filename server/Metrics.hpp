@@ -0,0 +1,114 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __METRICS_HPP__
+#define __METRICS_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace kurento
+{
+
+/*
+ * Recording only touches the shard of the calling thread with relaxed
+ * atomic operations, so metrics can stay enabled on hot paths. Threads are
+ * spread over a fixed number of shards, which are added up when read.
+ */
+#define METRIC_SHARDS 8
+
+/**
+ * Monotonic counter
+ */
+class Counter
+{
+public:
+  Counter ();
+
+  void add (uint64_t n = 1);
+  uint64_t get () const;
+
+private:
+  struct Shard {
+    std::atomic<uint64_t> value;
+    /* Keep shards on different cache lines */
+    char padding[64 - sizeof (std::atomic<uint64_t>)];
+  };
+
+  Shard shards[METRIC_SHARDS];
+};
+
+/**
+ * Histogram with buckets of logarithmic size, each power of two split in 8
+ * linear sub-buckets, as HdrHistogram does. Values are recorded with an
+ * error below 12.5%, count, sum and max are exact.
+ */
+class Histogram
+{
+public:
+  /* Values from 0 to 2^40, larger ones go to the last bucket */
+  static const unsigned int BUCKETS = 8 + 37 * 8;
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Snapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::vector<uint64_t> buckets = std::vector<uint64_t> (BUCKETS);
+
+    double mean () const;
+
+    /**
+     * @param p From 0 to 1
+     * @returns The highest value of the bucket containing the percentile
+     */
+    uint64_t percentile (double p) const;
+
+    void merge (const Snapshot &other);
+  };
+
+  Histogram ();
+
+  void record (uint64_t value);
+
+  /**
+   * Record the microseconds elapsed since start
+   */
+  void recordSince (Clock::time_point start);
+
+  Snapshot getSnapshot () const;
+
+  static unsigned int getBucket (uint64_t value);
+  static uint64_t getBucketMax (unsigned int bucket);
+
+private:
+  struct Shard {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+    std::atomic<uint64_t> buckets[BUCKETS];
+  };
+
+  Shard shards[METRIC_SHARDS];
+};
+
+} /* kurento */
+
+#endif /* __METRICS_HPP__ */
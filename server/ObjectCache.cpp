@@ -0,0 +1,252 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "ObjectCache.hpp"
+
+#include <algorithm>
+
+#define CACHE_SHARDS 16
+/* Adds to a shard between sweeps of the sessions no longer used */
+#define PURGE_INTERVAL 256
+
+namespace kurento
+{
+
+/* Children ids start with the id of their pipeline and a slash */
+static std::string
+getPipelineId (const std::string &objectId)
+{
+  return objectId.substr (0, objectId.find ('/') );
+}
+
+ObjectCache::ObjectCache (unsigned int maxObjects) :
+  maxObjects (std::max (maxObjects, 1u) )
+{
+  for (unsigned int i = 0; i < CACHE_SHARDS; i++) {
+    shards.push_back (std::unique_ptr<Shard> (new Shard () ) );
+  }
+}
+
+ObjectCache::Shard &
+ObjectCache::getShard (const std::string &sessionId)
+{
+  return *shards[std::hash<std::string> () (sessionId) % shards.size()];
+}
+
+void
+ObjectCache::addToIndex (const std::string &sessionId,
+                         const std::string &objectId)
+{
+  std::unique_lock<std::mutex> lock (indexMutex);
+
+  index[getPipelineId (objectId)][sessionId]++;
+}
+
+void
+ObjectCache::removeFromIndex (const std::string &sessionId,
+                              const std::string &objectId)
+{
+  std::unique_lock<std::mutex> lock (indexMutex);
+  auto pipeline = index.find (getPipelineId (objectId) );
+
+  if (pipeline == index.end () ) {
+    return;
+  }
+
+  auto session = pipeline->second.find (sessionId);
+
+  if (session != pipeline->second.end () && --session->second == 0) {
+    pipeline->second.erase (session);
+  }
+
+  if (pipeline->second.empty () ) {
+    index.erase (pipeline);
+  }
+}
+
+std::shared_ptr<MediaObjectImpl>
+ObjectCache::getObject (const std::string &sessionId,
+                        const std::string &objectId)
+{
+  Shard &shard = getShard (sessionId);
+  std::unique_lock<std::mutex> lock (shard.mutex);
+  auto session = shard.sessions.find (sessionId);
+
+  if (session == shard.sessions.end ()
+      || session->second.validUntil < Clock::now () ) {
+    return nullptr;
+  }
+
+  std::vector<Entry> &entries = session->second.entries;
+
+  for (auto it = entries.begin (); it != entries.end (); it++) {
+    if (it->objectId != objectId) {
+      continue;
+    }
+
+    std::shared_ptr<MediaObjectImpl> object = it->object.lock ();
+
+    if (!object) {
+      removeFromIndex (sessionId, objectId);
+      entries.erase (it);
+      return nullptr;
+    }
+
+    return object;
+  }
+
+  return nullptr;
+}
+
+void
+ObjectCache::addObject (const std::string &sessionId,
+                        const std::string &objectId, std::shared_ptr<MediaObjectImpl> object)
+{
+  Shard &shard = getShard (sessionId);
+  std::unique_lock<std::mutex> lock (shard.mutex);
+
+  if (++shard.adds % PURGE_INTERVAL == 0) {
+    purge (shard);
+  }
+
+  std::vector<Entry> &entries = shard.sessions[sessionId].entries;
+
+  for (Entry &entry : entries) {
+    if (entry.objectId == objectId) {
+      entry.object = object;
+      return;
+    }
+  }
+
+  if (entries.size () >= maxObjects) {
+    removeFromIndex (sessionId, entries.front ().objectId);
+    entries.erase (entries.begin () );
+  }
+
+  entries.push_back (Entry {objectId, object});
+  addToIndex (sessionId, objectId);
+}
+
+void
+ObjectCache::keepAlive (const std::string &sessionId, Clock::duration validity)
+{
+  Shard &shard = getShard (sessionId);
+  std::unique_lock<std::mutex> lock (shard.mutex);
+
+  shard.sessions[sessionId].validUntil = Clock::now () + validity;
+}
+
+/* Drops the sessions the MediaSet may have released */
+void
+ObjectCache::purge (Shard &shard)
+{
+  Clock::time_point now = Clock::now ();
+
+  for (auto it = shard.sessions.begin (); it != shard.sessions.end ();) {
+    if (it->second.validUntil >= now) {
+      it++;
+      continue;
+    }
+
+    for (const Entry &entry : it->second.entries) {
+      removeFromIndex (it->first, entry.objectId);
+    }
+
+    it = shard.sessions.erase (it);
+  }
+}
+
+void
+ObjectCache::removeObject (const std::string &objectId)
+{
+  std::string prefix = objectId + "/";
+  std::vector<std::string> sessionIds;
+
+  auto removed = [&objectId, &prefix] (const Entry & entry) {
+    return entry.objectId == objectId
+           || entry.objectId.compare (0, prefix.size (), prefix) == 0;
+  };
+
+  {
+    std::unique_lock<std::mutex> lock (indexMutex);
+    auto pipeline = index.find (getPipelineId (objectId) );
+
+    if (pipeline == index.end () ) {
+      return;
+    }
+
+    for (auto &session : pipeline->second) {
+      sessionIds.push_back (session.first);
+    }
+  }
+
+  /* Only the sessions with objects of the same pipeline are visited */
+  for (const std::string &sessionId : sessionIds) {
+    Shard &shard = getShard (sessionId);
+    std::unique_lock<std::mutex> lock (shard.mutex);
+    auto session = shard.sessions.find (sessionId);
+
+    if (session == shard.sessions.end () ) {
+      continue;
+    }
+
+    std::vector<Entry> &entries = session->second.entries;
+    auto first = std::remove_if (entries.begin (), entries.end (), removed);
+
+    for (auto it = first; it != entries.end (); it++) {
+      removeFromIndex (sessionId, it->objectId);
+    }
+
+    entries.erase (first, entries.end () );
+  }
+}
+
+void
+ObjectCache::removeSession (const std::string &sessionId)
+{
+  Shard &shard = getShard (sessionId);
+  std::unique_lock<std::mutex> lock (shard.mutex);
+  auto session = shard.sessions.find (sessionId);
+
+  if (session == shard.sessions.end () ) {
+    return;
+  }
+
+  for (const Entry &entry : session->second.entries) {
+    removeFromIndex (sessionId, entry.objectId);
+  }
+
+  shard.sessions.erase (session);
+}
+
+void
+ObjectCache::clear ()
+{
+  std::vector<std::unique_lock<std::mutex>> locks;
+
+  /* All at once, or entries added meanwhile could be missing from the index */
+  for (auto &shard : shards) {
+    locks.push_back (std::unique_lock<std::mutex> (shard->mutex) );
+    shard->sessions.clear ();
+  }
+
+  std::unique_lock<std::mutex> lock (indexMutex);
+
+  index.clear ();
+}
+
+} /* kurento */
@@ -0,0 +1,116 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __OBJECT_CACHE_HPP__
+#define __OBJECT_CACHE_HPP__
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <MediaObjectImpl.hpp>
+
+namespace kurento
+{
+
+/**
+ * Objects recently used by each session, so requests on the same object do
+ * not look it up in the MediaSet again. Only weak references are kept.
+ *
+ * Entries are removed when the object is released or unreferenced through
+ * the server methods. The MediaSet also releases, on its own, sessions not
+ * kept alive during a collector interval, with their objects. So entries of
+ * a session are only used while its last keep alive is recent enough for the
+ * session to still exist.
+ */
+class ObjectCache
+{
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * @param maxObjects Objects kept per session, the oldest one is dropped
+   */
+  ObjectCache (unsigned int maxObjects);
+  ~ObjectCache () {};
+
+  /**
+   * @returns The object, or nullptr if it is not cached for the session or
+   *          the session may have been released
+   */
+  std::shared_ptr<MediaObjectImpl> getObject (const std::string &sessionId,
+      const std::string &objectId);
+
+  void addObject (const std::string &sessionId, const std::string &objectId,
+                  std::shared_ptr<MediaObjectImpl> object);
+
+  /**
+   * Record that the MediaSet kept the session alive, so it will not release
+   * it before validity
+   */
+  void keepAlive (const std::string &sessionId, Clock::duration validity);
+
+  /**
+   * Remove an object, and its children, from every session
+   */
+  void removeObject (const std::string &objectId);
+
+  void removeSession (const std::string &sessionId);
+
+  void clear ();
+
+private:
+  struct Entry {
+    std::string objectId;
+    std::weak_ptr<MediaObjectImpl> object;
+  };
+
+  struct Session {
+    std::vector<Entry> entries;
+    Clock::time_point validUntil;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, Session> sessions;
+    unsigned int adds = 0;
+  };
+
+  Shard &getShard (const std::string &sessionId);
+  void purge (Shard &shard);
+  void addToIndex (const std::string &sessionId, const std::string &objectId);
+  void removeFromIndex (const std::string &sessionId,
+                        const std::string &objectId);
+
+  std::vector<std::unique_ptr<Shard>> shards;
+  unsigned int maxObjects;
+
+  /*
+   * Sessions with entries for the objects of each pipeline, by the id of the
+   * pipeline, and how many. Taken after a shard mutex, never before.
+   */
+  std::mutex indexMutex;
+  std::unordered_map<std::string, std::unordered_map<std::string, unsigned int>>
+      index;
+};
+
+} /* kurento */
+
+#endif /* __OBJECT_CACHE_HPP__ */
@@ -24,72 +24,161 @@
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 #define GST_DEFAULT_NAME "KurentoRequestCache"
 
+/* Next stuff is included to avoid problems with slots and lamdas */
+#include <type_traits>
+#include <sigc++/sigc++.h>
+#include <event2/event_struct.h>
+#include <config.h>
+#if FIX_SIGC
+namespace sigc
+{
+template <typename Functor>
+struct functor_trait<Functor, false> {
+  typedef decltype (::sigc::mem_fun (std::declval<Functor &> (),
+                                     &Functor::operator() ) ) _intermediate;
+
+  typedef typename _intermediate::result_type result_type;
+  typedef Functor functor_type;
+};
+}
+#endif
+
+#define CACHE_SHARDS 64
+
 namespace kurento
 {
 
-RequestCache::RequestCache (unsigned int timeout)
+RequestCache::RequestCache (unsigned int timeout, unsigned int resolution)
 {
+  unsigned int ticks;
+
   this->timeout = timeout;
+
+  if (resolution == 0) {
+    resolution = 1;
+  }
+
+  /* One extra bucket so a new entry never lands on the current one */
+  ticks = timeout / resolution + 1;
+
+  for (unsigned int i = 0; i < CACHE_SHARDS; i++) {
+    shards.push_back (std::unique_ptr<Shard> (new Shard () ) );
+    shards.back()->wheel.resize (ticks + 1);
+  }
+
+  source = Glib::TimeoutSource::create (resolution);
+  source->connect ( [this] () -> bool {
+    this->expire ();
+    return true;
+  });
+
+  source->attach();
 }
 
 RequestCache::~RequestCache ()
 {
+  source->destroy();
+}
+
+RequestCache::Shard &
+RequestCache::getShard (const std::string &sessionId)
+{
+  return *shards[std::hash<std::string> () (sessionId) % shards.size()];
 }
 
 void
-RequestCache::addResponse (std::string sessionId, std::string requestId,
-                           Json::Value &response)
+RequestCache::expire ()
 {
-  std::shared_ptr<CacheEntry> entry;
-  std::unique_lock<std::recursive_mutex> lock (mutex);
+  size_t nExpired = 0;
 
-  entry = std::shared_ptr<CacheEntry> (new CacheEntry (timeout, sessionId,
-                                       requestId, response) );
+  for (auto &shard : shards) {
+    std::vector<ExpiryRecord> expired;
+    std::unique_lock<std::mutex> lock (shard->mutex);
 
-  cache[sessionId][requestId] = entry;
-  entry->signalTimeout.connect ([this, sessionId, requestId] () {
-    std::unique_lock<std::recursive_mutex> lock (mutex);
-    auto it1 = this->cache.find (sessionId);
+    shard->currentSlot = (shard->currentSlot + 1) % shard->wheel.size();
+    expired.swap (shard->wheel[shard->currentSlot]);
 
-    if (it1 == this->cache.end() ) {
-      return;
-    }
+    for (const ExpiryRecord &record : expired) {
+      auto it1 = shard->sessions.find (record.sessionId);
 
-    auto it2 = this->cache[sessionId].find (requestId);
+      if (it1 == shard->sessions.end() ) {
+        continue;
+      }
 
-    if (it2 == this->cache[sessionId].end() ) {
-      return;
-    }
+      auto it2 = it1->second.find (record.requestId);
+
+      /* The response may have been replaced by a newer one */
+      if (it2 == it1->second.end() || it2->second != record.entry.lock() ) {
+        continue;
+      }
 
-    this->cache[sessionId].erase (it2);
+      it1->second.erase (it2);
 
-    if (this->cache[sessionId].empty() ) {
-      this->cache.erase (it1);
+      if (it1->second.empty() ) {
+        shard->sessions.erase (it1);
+      }
     }
-  });
+
+    lock.unlock ();
+    nExpired += expired.size();
+  }
+
+  GST_TRACE ("Expired %" G_GSIZE_FORMAT " cached responses", nExpired);
 }
 
-Json::Value
-RequestCache::getCachedResponse (std::string sessionId, std::string requestId)
+void
+RequestCache::addResponse (const std::string &sessionId,
+                           const std::string &requestId, const std::string &response,
+                           const std::string &responseSessionId)
 {
-  std::map<std::string, std::shared_ptr <CacheEntry>> requests;
+  std::shared_ptr<CacheEntry> entry;
+  unsigned int slot;
+  Shard &shard = getShard (sessionId);
 
-  std::unique_lock<std::recursive_mutex> lock (mutex);
+  entry = std::shared_ptr<CacheEntry> (new CacheEntry (sessionId, requestId,
+                                       response, responseSessionId) );
 
-  auto it1 = cache.find (sessionId);
+  std::unique_lock<std::mutex> lock (shard.mutex);
 
-  if (it1 == cache.end() ) {
-    throw CacheException ("Session not cached");
-  }
+  shard.sessions[sessionId][requestId] = entry;
 
-  requests = cache[sessionId];
-  auto it2 = requests.find (requestId);
+  slot = (shard.currentSlot + shard.wheel.size() - 1) % shard.wheel.size();
+  shard.wheel[slot].push_back ({sessionId, requestId, entry});
+}
+
+std::shared_ptr<CacheEntry>
+RequestCache::getCachedResponse (const std::string &sessionId,
+                                 const std::string &requestId)
+{
+  std::shared_ptr<CacheEntry> entry = findCachedResponse (sessionId, requestId);
 
-  if (it2 == requests.end() ) {
+  if (!entry) {
     throw CacheException ("Response not cached");
   }
 
-  return requests[requestId]->getResponse();
+  return entry;
+}
+
+std::shared_ptr<CacheEntry>
+RequestCache::findCachedResponse (const std::string &sessionId,
+                                  const std::string &requestId)
+{
+  Shard &shard = getShard (sessionId);
+  std::unique_lock<std::mutex> lock (shard.mutex);
+
+  auto it1 = shard.sessions.find (sessionId);
+
+  if (it1 == shard.sessions.end() ) {
+    return std::shared_ptr<CacheEntry> ();
+  }
+
+  auto it2 = it1->second.find (requestId);
+
+  if (it2 == it1->second.end() ) {
+    return std::shared_ptr<CacheEntry> ();
+  }
+
+  return it2->second;
 }
 
 RequestCache::StaticConstructor RequestCache::staticConstructor;
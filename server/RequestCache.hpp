@@ -19,31 +19,89 @@
 #define __REQUEST_CACHE_H__
 
 #include <memory>
-#include <map>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
-#include <json/json.h>
+#include <glibmm.h>
 
 namespace kurento
 {
 
 class CacheEntry;
 
+/**
+ * Responses are stored in shards selected by a hash of the sessionId, each one
+ * with its own lock, so different sessions rarely contend.
+ *
+ * Each shard expires its responses with a timing wheel: a ring of buckets
+ * advanced by a single timer, so entries expire in
+ * [timeout, timeout + resolution).
+ */
 class RequestCache
 {
 public:
-  RequestCache (unsigned int timeout);
-  void addResponse (std::string sessionId, std::string requestId,
-                    Json::Value &response);
-  Json::Value getCachedResponse (std::string sessionId, std::string requestId);
+  RequestCache (unsigned int timeout, unsigned int resolution = 1000);
+  /**
+   * Cache a response
+   *
+   * @param sessionId The session the request belongs to
+   * @param requestId The id of the request
+   * @param response The serialized response
+   * @param responseSessionId The sessionId to associate with the connection
+   *                          when the response is sent again
+   */
+  void addResponse (const std::string &sessionId, const std::string &requestId,
+                    const std::string &response, const std::string &responseSessionId);
+  /**
+   * Look up a cached response
+   *
+   * @returns The shared cache entry, the response is not copied
+   * @throws CacheException if the response is not cached
+   */
+  std::shared_ptr<CacheEntry> getCachedResponse (const std::string &sessionId,
+      const std::string &requestId);
+  /**
+   * Look up a cached response without throwing on a miss, which is the
+   * common case
+   *
+   * @returns The shared cache entry, or nullptr if the response is not cached
+   */
+  std::shared_ptr<CacheEntry> findCachedResponse (const std::string &sessionId,
+      const std::string &requestId);
   ~RequestCache ();
 
+  /**
+   * Advance the wheel one bucket, removing the responses expired in it.
+   * Called by the cache timer every resolution period.
+   */
+  void expire ();
+
 private:
-  std::map<std::string, std::map<std::string, std::shared_ptr <CacheEntry>>>
-  cache;
-  std::recursive_mutex mutex;
+  struct ExpiryRecord {
+    std::string sessionId;
+    std::string requestId;
+    std::weak_ptr<CacheEntry> entry;
+  };
+
+  typedef std::unordered_map<std::string, std::shared_ptr <CacheEntry>>
+      SessionRequests;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, SessionRequests> sessions;
+    std::vector<std::vector<ExpiryRecord>> wheel;
+    unsigned int currentSlot = 0;
+  };
+
+  Shard &getShard (const std::string &sessionId);
+
+  std::vector<std::unique_ptr<Shard>> shards;
   unsigned int timeout;
 
+  Glib::RefPtr<Glib::TimeoutSource> source;
+
   class StaticConstructor
   {
   public:
@@ -0,0 +1,393 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "RequestEnvelope.hpp"
+#include "JsonBuffers.hpp"
+
+#include <cctype>
+#include <cstring>
+
+#include <jsonrpc/JsonRpcConstants.hpp>
+
+#define SESSION_ID "sessionId"
+
+/* Nesting allowed when skipping values, as Json::Reader does */
+#define MAX_DEPTH 1000
+
+namespace kurento
+{
+
+static void
+skipWhitespace (const char *&p, const char *end)
+{
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') ) {
+    p++;
+  }
+}
+
+/*
+ * Reads a string, leaving p after the closing quote. Contents are only
+ * returned if there are no escape sequences, otherwise they would need to be
+ * decoded.
+ */
+static bool
+readString (const char *&p, const char *end, const char *&start,
+            const char *&stop, bool &escaped)
+{
+  if (p >= end || *p != '"') {
+    return false;
+  }
+
+  escaped = false;
+  start = ++p;
+
+  while (p < end) {
+    if (*p == '\\') {
+      escaped = true;
+      p += 2;
+    } else if (*p == '"') {
+      stop = p++;
+      return true;
+    } else if ( (unsigned char) *p < 0x20) {
+      return false;
+    } else {
+      p++;
+    }
+  }
+
+  return false;
+}
+
+static bool
+readPlainString (const char *&p, const char *end, std::string &value)
+{
+  const char *start, *stop;
+  bool escaped;
+
+  if (!readString (p, end, start, stop, escaped) || escaped) {
+    return false;
+  }
+
+  value.assign (start, stop);
+
+  return true;
+}
+
+static bool
+skipLiteral (const char *&p, const char *end)
+{
+  const char *start = p;
+
+  while (p < end && (isalnum ( (unsigned char) *p) || *p == '-' || *p == '+'
+                     || *p == '.') ) {
+    p++;
+  }
+
+  if (p == start) {
+    return false;
+  }
+
+  if (isdigit ( (unsigned char) *start) || *start == '-') {
+    for (const char *c = start; c < p; c++) {
+      if (!isdigit ( (unsigned char) *c) && !strchr ("-+.eE", *c) ) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  return (p - start == 4 && (strncmp (start, "true", 4) == 0
+                             || strncmp (start, "null", 4) == 0) )
+         || (p - start == 5 && strncmp (start, "false", 5) == 0);
+}
+
+static bool skipValue (const char *&p, const char *end, int depth);
+
+static bool
+skipContainer (const char *&p, const char *end, bool object, int depth)
+{
+  char close = object ? '}' : ']';
+
+  p++;
+  skipWhitespace (p, end);
+
+  if (p < end && *p == close) {
+    p++;
+    return true;
+  }
+
+  while (p < end) {
+    if (object) {
+      const char *start, *stop;
+      bool escaped;
+
+      if (!readString (p, end, start, stop, escaped) ) {
+        return false;
+      }
+
+      skipWhitespace (p, end);
+
+      if (p >= end || *p != ':') {
+        return false;
+      }
+
+      p++;
+    }
+
+    if (!skipValue (p, end, depth + 1) ) {
+      return false;
+    }
+
+    skipWhitespace (p, end);
+
+    if (p >= end) {
+      return false;
+    }
+
+    if (*p == close) {
+      p++;
+      return true;
+    }
+
+    if (*p != ',') {
+      return false;
+    }
+
+    p++;
+    skipWhitespace (p, end);
+  }
+
+  return false;
+}
+
+static bool
+skipValue (const char *&p, const char *end, int depth)
+{
+  const char *start, *stop;
+  bool escaped;
+
+  skipWhitespace (p, end);
+
+  if (p >= end || depth > MAX_DEPTH) {
+    return false;
+  }
+
+  switch (*p) {
+  case '"':
+    return readString (p, end, start, stop, escaped);
+
+  case '{':
+    return skipContainer (p, end, true, depth);
+
+  case '[':
+    return skipContainer (p, end, false, depth);
+
+  default:
+    return skipLiteral (p, end);
+  }
+}
+
+/*
+ * Calls onMember for every member of the object at p, with p at the start of
+ * the value. onMember must leave p after the value.
+ */
+template <typename F>
+static bool
+scanObject (const char *&p, const char *end, F onMember)
+{
+  skipWhitespace (p, end);
+
+  if (p >= end || *p != '{') {
+    return false;
+  }
+
+  p++;
+  skipWhitespace (p, end);
+
+  if (p < end && *p == '}') {
+    p++;
+    return true;
+  }
+
+  while (p < end) {
+    std::string key;
+
+    if (!readPlainString (p, end, key) ) {
+      return false;
+    }
+
+    skipWhitespace (p, end);
+
+    if (p >= end || *p != ':') {
+      return false;
+    }
+
+    p++;
+    skipWhitespace (p, end);
+
+    if (!onMember (key) ) {
+      return false;
+    }
+
+    skipWhitespace (p, end);
+
+    if (p >= end) {
+      return false;
+    }
+
+    if (*p == '}') {
+      p++;
+      return true;
+    }
+
+    if (*p != ',') {
+      return false;
+    }
+
+    p++;
+    skipWhitespace (p, end);
+  }
+
+  return false;
+}
+
+void
+RequestEnvelope::reset ()
+{
+  jsonRpc = boost::none;
+  method = boost::none;
+  id = boost::none;
+  sessionId = boost::none;
+  idToken.clear ();
+  params = false;
+  otherParams = false;
+}
+
+bool
+RequestEnvelope::scan (const std::string &request)
+{
+  const char *p = request.data ();
+  const char *end = p + request.size ();
+  bool ok;
+
+  reset ();
+
+  ok = scanObject (p, end, [&] (const std::string & key) {
+    std::string value;
+
+    if (key == JSON_RPC_PROTO || key == JSON_RPC_METHOD) {
+      if (!readPlainString (p, end, value) ) {
+        return false;
+      }
+
+      if (key == JSON_RPC_PROTO) {
+        jsonRpc = value;
+      } else {
+        method = value;
+      }
+
+      return true;
+    } else if (key == JSON_RPC_ID) {
+      const char *start = p;
+
+      if (!skipValue (p, end, 1) ) {
+        return false;
+      }
+
+      idToken.assign (start, p);
+      id = boost::none;
+
+      if (*start == '"') {
+        const char *q = start;
+
+        if (readPlainString (q, end, value) ) {
+          id = value;
+        }
+      } else if (idToken.find_first_of (".eE") == std::string::npos
+                 && idToken != "null" && idToken != "true"
+                 && idToken != "false") {
+        id = idToken;
+      }
+
+      return true;
+    } else if (key == JSON_RPC_PARAMS) {
+      params = true;
+      otherParams = false;
+      sessionId = boost::none;
+
+      return scanObject (p, end, [&] (const std::string & param) {
+        if (param != SESSION_ID) {
+          otherParams = true;
+          return skipValue (p, end, 2);
+        }
+
+        if (!readPlainString (p, end, value) ) {
+          return false;
+        }
+
+        sessionId = value;
+        return true;
+      });
+    }
+
+    return skipValue (p, end, 1);
+  });
+
+  skipWhitespace (p, end);
+
+  if (!ok || p != end) {
+    reset ();
+    return false;
+  }
+
+  return true;
+}
+
+Json::Value
+RequestEnvelope::toRequest () const
+{
+  Json::Value request (Json::objectValue);
+
+  if (jsonRpc) {
+    request[JSON_RPC_PROTO] = *jsonRpc;
+  }
+
+  if (method) {
+    request[JSON_RPC_METHOD] = *method;
+  }
+
+  if (!idToken.empty () ) {
+    Json::Value value;
+
+    if (parseJson (idToken, value) ) {
+      request[JSON_RPC_ID] = value;
+    }
+  }
+
+  if (params) {
+    request[JSON_RPC_PARAMS] = Json::Value (Json::objectValue);
+  }
+
+  if (sessionId) {
+    request[JSON_RPC_PARAMS][SESSION_ID] = *sessionId;
+  }
+
+  return request;
+}
+
+} /* kurento */
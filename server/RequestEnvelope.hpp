@@ -0,0 +1,109 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __REQUEST_ENVELOPE_HPP__
+#define __REQUEST_ENVELOPE_HPP__
+
+#include <string>
+#include <boost/optional.hpp>
+#include <json/json.h>
+
+namespace kurento
+{
+
+/**
+ * Fields of a JSON-RPC request needed to route it, extracted by scanning the
+ * message once without building a Json::Value tree: jsonrpc, id, method and
+ * params.sessionId. The rest of the params are skipped.
+ *
+ * Scanning is conservative: it fails on anything it does not fully
+ * understand (escaped strings, params that are not an object, malformed
+ * JSON...), and the request must then be parsed with Json::Reader.
+ */
+class RequestEnvelope
+{
+public:
+  RequestEnvelope () {};
+  ~RequestEnvelope () {};
+
+  /**
+   * Scan a request
+   *
+   * @param request The request as received
+   * @returns true if the envelope could be extracted
+   */
+  bool scan (const std::string &request);
+
+  const boost::optional<std::string> &getJsonRpc () const
+  {
+    return jsonRpc;
+  }
+
+  const boost::optional<std::string> &getMethod () const
+  {
+    return method;
+  }
+
+  /**
+   * @returns The id as the string used as key in the request cache, not set
+   *          if the request has no id or it is not a string or an integer
+   */
+  const boost::optional<std::string> &getId () const
+  {
+    return id;
+  }
+
+  const boost::optional<std::string> &getSessionId () const
+  {
+    return sessionId;
+  }
+
+  bool hasParams () const
+  {
+    return params;
+  }
+
+  /**
+   * @returns true if the params have members other than sessionId, which
+   *          are not kept by toRequest
+   */
+  bool hasOtherParams () const
+  {
+    return otherParams;
+  }
+
+  /**
+   * Build a request with just the scanned fields. Only valid if there are no
+   * other params, or the method does not use them.
+   */
+  Json::Value toRequest () const;
+
+private:
+  void reset ();
+
+  boost::optional<std::string> jsonRpc;
+  boost::optional<std::string> method;
+  boost::optional<std::string> id;
+  boost::optional<std::string> sessionId;
+  std::string idToken;
+  bool params = false;
+  bool otherParams = false;
+};
+
+} /* kurento */
+
+#endif /* __REQUEST_ENVELOPE_HPP__ */
@@ -24,7 +24,14 @@
 #include <KurentoException.hpp>
 #include <MediaSet.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <dirent.h>
 #include <sys/resource.h>
+#include <unistd.h>
 
 #define GST_CAT_DEFAULT kurento_resource_manager
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
@@ -36,6 +43,12 @@ namespace kurento
 static int maxOpenFiles = 0;
 static int maxThreads = 0;
 
+static std::shared_ptr<const ResourceUsage> lastUsage;
+static std::atomic<bool> monitorRunning (false);
+static std::thread monitorThread;
+static std::mutex monitorMutex;
+static std::condition_variable monitorCond;
+
 static int
 get_int (std::string &str, char sep, int nToken)
 {
@@ -81,23 +94,6 @@ getMaxThreads ()
   return maxThreads;
 }
 
-static void
-checkThreads (float limit_percent)
-{
-  int nThreads;
-  int maxThreads = getMaxThreads ();
-
-  if (maxThreads <= 0) {
-    return;
-  }
-
-  nThreads = getNumberOfThreads ();
-
-  if (nThreads > maxThreads * limit_percent ) {
-    throw KurentoException (NOT_ENOUGH_RESOURCES, "Too many threads");
-  }
-}
-
 static int
 getMaxOpenFiles ()
 {
@@ -120,6 +116,10 @@ getNumberOfOpenFiles ()
 
   d = opendir ("/proc/self/fd");
 
+  if (d == NULL) {
+    return 0;
+  }
+
   while ( (dir = readdir (d) ) != NULL) {
     openFiles ++;
   }
@@ -129,37 +129,150 @@ getNumberOfOpenFiles ()
   return openFiles;
 }
 
+static uint64_t
+getResidentBytes ()
+{
+  std::ifstream statm_file ("/proc/self/statm");
+  uint64_t size = 0, resident = 0;
+
+  statm_file >> size >> resident;
+
+  return resident * sysconf (_SC_PAGESIZE);
+}
+
+static std::chrono::microseconds
+getCpuTime ()
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return std::chrono::seconds (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         std::chrono::microseconds (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+static std::shared_ptr<const ResourceUsage>
+sampleResources (std::shared_ptr<const ResourceUsage> previous,
+                 std::chrono::microseconds &cpuTime)
+{
+  std::shared_ptr<ResourceUsage> usage (new ResourceUsage () );
+  std::chrono::microseconds newCpuTime = getCpuTime ();
+
+  usage->threads = getNumberOfThreads ();
+  usage->maxThreads = getMaxThreads ();
+  usage->openFiles = getNumberOfOpenFiles ();
+  usage->maxOpenFiles = getMaxOpenFiles ();
+  usage->rssBytes = getResidentBytes ();
+  usage->sampled = std::chrono::steady_clock::now ();
+  usage->cpuPercent = 0;
+
+  if (previous && usage->sampled > previous->sampled) {
+    usage->cpuPercent = 100.0 * (newCpuTime - cpuTime).count () /
+                        std::chrono::duration_cast<std::chrono::microseconds>
+                        (usage->sampled - previous->sampled).count ();
+  }
+
+  cpuTime = newCpuTime;
+
+  return usage;
+}
+
 static void
-checkOpenFiles (float limit_percent)
+checkUsage (const ResourceUsage &usage, float limit_percent)
 {
-  int nOpenFiles;
-  int maxOpenFiles = getMaxOpenFiles ();
+  if (usage.maxThreads > 0
+      && usage.threads > usage.maxThreads * limit_percent) {
+    throw KurentoException (NOT_ENOUGH_RESOURCES, "Too many threads");
+  }
+
+  if (usage.maxOpenFiles > 0
+      && usage.openFiles > usage.maxOpenFiles * limit_percent) {
+    throw KurentoException (NOT_ENOUGH_RESOURCES, "Too many open files");
+  }
+}
+
+static void
+runResourceMonitor (std::chrono::milliseconds interval)
+{
+  std::chrono::microseconds cpuTime = getCpuTime ();
+  std::shared_ptr<const ResourceUsage> usage;
+  std::unique_lock<std::mutex> lock (monitorMutex);
+
+  while (monitorRunning) {
+    lock.unlock ();
+    usage = sampleResources (usage, cpuTime);
+    std::atomic_store (&lastUsage, usage);
+    lock.lock ();
+
+    monitorCond.wait_for (lock, interval, [] () {
+      return !monitorRunning;
+    });
+  }
+}
+
+void
+startResourceMonitor (std::chrono::milliseconds interval)
+{
+  std::chrono::microseconds cpuTime = getCpuTime ();
 
-  if (maxOpenFiles <= 0) {
+  if (monitorRunning.exchange (true) ) {
     return;
   }
 
-  nOpenFiles = getNumberOfOpenFiles ();
+  /* Requests never wait for the first sample */
+  std::atomic_store (&lastUsage, sampleResources (nullptr, cpuTime) );
 
-  if (nOpenFiles > maxOpenFiles * limit_percent ) {
-    throw KurentoException (NOT_ENOUGH_RESOURCES, "Too many open files");
+  monitorThread = std::thread (std::bind (runResourceMonitor, interval) );
+
+  GST_INFO ("Resource monitor started, sampling every %d ms",
+            (int) interval.count () );
+}
+
+void
+stopResourceMonitor ()
+{
+  std::unique_lock<std::mutex> lock (monitorMutex);
+
+  if (!monitorRunning.exchange (false) ) {
+    return;
   }
+
+  monitorCond.notify_all ();
+  lock.unlock ();
+
+  monitorThread.join ();
+  std::atomic_store (&lastUsage, std::shared_ptr<const ResourceUsage> () );
+}
+
+std::shared_ptr<const ResourceUsage>
+getResourceUsage ()
+{
+  std::shared_ptr<const ResourceUsage> usage = std::atomic_load (&lastUsage);
+  std::chrono::microseconds cpuTime = getCpuTime ();
+
+  if (usage) {
+    return usage;
+  }
+
+  return sampleResources (nullptr, cpuTime);
 }
 
 void
 checkResources (float limit_percent)
 {
-  checkThreads (limit_percent);
-  checkOpenFiles (limit_percent);
+  checkUsage (*getResourceUsage (), limit_percent);
 }
 
 void killServerOnLowResources (float limit_percent)
 {
   MediaSet::getMediaSet()->signalEmptyLocked.connect ([limit_percent] () {
+    std::chrono::microseconds cpuTime = getCpuTime ();
+
     GST_DEBUG ("MediaSet empty, checking resources");
 
     try {
-      checkResources (limit_percent);
+      /* Rare and decides killing the server, so do not use an old sample */
+      checkUsage (*sampleResources (nullptr, cpuTime), limit_percent);
     } catch (KurentoException &e) {
       if (e.getCode() == NOT_ENOUGH_RESOURCES) {
         GST_ERROR ("Resources over the limit, server will be killed");
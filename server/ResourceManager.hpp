@@ -18,15 +18,48 @@
 #ifndef __RESOURCE_MANAGER_H__
 #define __RESOURCE_MANAGER_H__
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
 namespace kurento
 {
 
 static const float DEFAULT_RESOURCE_LIMIT_PERCENT = 0.8;
 
+/* Resources used by the process at some point */
+struct ResourceUsage {
+  int threads;
+  int maxThreads;
+  int openFiles;
+  int maxOpenFiles;
+  uint64_t rssBytes;
+  /* Since the previous sample, 100 is one core fully used */
+  double cpuPercent;
+  std::chrono::steady_clock::time_point sampled;
+};
+
+/**
+ * Throws NOT_ENOUGH_RESOURCES if threads or open files are over the limit,
+ * checking the last sample of the resource monitor if it is running
+ */
 void checkResources (float limit_percent);
 
 void killServerOnLowResources (float limit_percent);
 
+/**
+ * Sample the resource usage periodically from a background thread, so
+ * checking resources does not need to read /proc each time
+ */
+void startResourceMonitor (std::chrono::milliseconds interval);
+void stopResourceMonitor ();
+
+/**
+ * @returns The last sample of the resource monitor, or a new one if it is
+ *          not running
+ */
+std::shared_ptr<const ResourceUsage> getResourceUsage ();
+
 } /* kurento */
 
 #endif /* __RESOURCE_MANAGER_H__ */
@@ -26,7 +26,17 @@
 #include <jsonrpc/JsonRpcConstants.hpp>
 #include <jsonrpc/JsonFixes.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <set>
 #include <sstream>
+#include <boost/optional.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -40,6 +50,14 @@
 #include <UUIDGenerator.hpp>
 
 #include <ResourceManager.hpp>
+#include "CacheEntry.hpp"
+#include "ObjectCache.hpp"
+#include "RequestEnvelope.hpp"
+#include "TransactionGraph.hpp"
+#include "ServerStats.hpp"
+#include "JsonBuffers.hpp"
+#include "CompressionStats.hpp"
+#include "WriteStats.hpp"
 
 #define GST_CAT_DEFAULT kurento_server_methods
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
@@ -48,30 +66,44 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 #define SESSION_ID "sessionId"
 #define VALUE "value"
 #define OBJECT "object"
+#define OBJECTS "objects"
 #define SUBSCRIPTION "subscription"
 #define TYPE "type"
 #define QUALIFIED_TYPE "qualifiedType"
 #define HIERARCHY "hierarchy"
+#define ALIAS "alias"
+#define OBJECT_ALIASES "objectAliases"
 
 #define REQUEST_TIMEOUT 20000 /* 20 seconds */
+#define OBJECT_CACHE_SIZE 16
+#define DEFAULT_WORKER_THREADS 10
+#define DEFAULT_RESOURCE_MONITOR_INTERVAL 1000 /* 1 second */
 
 static const std::string KURENTO_MODULES_PATH = "KURENTO_MODULES_PATH";
 static const std::string NEW_REF = "newref:";
 
+/*
+ * Cheap control methods, processed ahead of the rest. Built from the envelope
+ * when the params only have a sessionId.
+ */
+static const std::set<std::string> CONTROL_METHODS = {"ping", "keepAlive", "connect"};
+
 namespace kurento
 {
 
 ServerMethods::ServerMethods (const boost::property_tree::ptree &config) :
-  config (config), moduleManager (getModuleManager() )
+  config (config), moduleManager (getModuleManager() ), connections (0)
 {
   std::string version (get_version() );
   std::vector<std::shared_ptr<ModuleInfo>> modules;
   std::shared_ptr<ServerType> type (new ServerType (ServerType::KMS) );
   std::vector<std::string> capabilities;
   std::shared_ptr <ServerInfo> serverInfo;
-  std::shared_ptr<MediaObjectImpl> serverManager;
   std::chrono::seconds collectorInterval;
   bool disableRequestCache;
+  bool disableObjectCache;
+  int workerThreads;
+  int monitorInterval;
 
   collectorInterval = std::chrono::seconds (
                         config.get<int> ("mediaServer.resources.garbageCollectorPeriod",
@@ -81,6 +113,9 @@ ServerMethods::ServerMethods (const boost::property_tree::ptree &config) :
   disableRequestCache = config.get<bool> ("mediaServer.disableRequestCache",
                                           false);
 
+  disableObjectCache = config.get<bool> ("mediaServer.disableObjectCache",
+                                         false);
+
   resourceLimitPercent =
     config.get<float> ("mediaServer.resources.exceptionLimit",
                        DEFAULT_RESOURCE_LIMIT_PERCENT);
@@ -88,6 +123,24 @@ ServerMethods::ServerMethods (const boost::property_tree::ptree &config) :
   GST_INFO ("Not enough resources exception will be raised when resources reach %f ",
             resourceLimitPercent);
 
+  monitorInterval = config.get<int> ("mediaServer.resources.monitorInterval",
+                                     DEFAULT_RESOURCE_MONITOR_INTERVAL);
+
+  if (monitorInterval > 0) {
+    startResourceMonitor (std::chrono::milliseconds (monitorInterval) );
+  } else {
+    GST_INFO ("Resource monitor disabled, resources will be checked on each creation");
+  }
+
+  workerThreads = config.get<int> ("mediaServer.workerThreads",
+                                   DEFAULT_WORKER_THREADS);
+
+  if (workerThreads > 0) {
+    workerPool = std::shared_ptr<WorkerPool> (new WorkerPool (workerThreads) );
+  } else {
+    GST_INFO ("Worker pool disabled, requests will be processed on transport threads");
+  }
+
   instanceId = generateUUID();
 
   for (auto moduleIt : moduleManager.getModules () ) {
@@ -103,69 +156,80 @@ ServerMethods::ServerMethods (const boost::property_tree::ptree &config) :
   }
 
   capabilities.push_back ("transactions");
+  capabilities.push_back ("describeObjects");
+  capabilities.push_back (OBJECT_ALIASES);
+  capabilities.push_back ("serverStats");
 
   serverInfo = std::shared_ptr <ServerInfo> (new ServerInfo (version, modules,
                type, capabilities) );
 
-  serverManager = MediaSet::getMediaSet ()->ref (new ServerManagerImpl (
-                    serverInfo, config, moduleManager) );
-  MediaSet::getMediaSet ()->setServerManager (std::dynamic_pointer_cast
-      <ServerManagerImpl> (serverManager) );
+  serverManager = std::dynamic_pointer_cast<ServerManagerImpl>
+                  (MediaSet::getMediaSet ()->ref (new ServerManagerImpl (
+                     serverInfo, config, moduleManager) ) );
+  MediaSet::getMediaSet ()->setServerManager (serverManager);
 
-  cache = std::shared_ptr<RequestCache> (new RequestCache (REQUEST_TIMEOUT) );
+  stats = std::shared_ptr<ServerStats> (new ServerStats (
+                                          getStaticMethodNames () ) );
 
   if (!disableRequestCache) {
-    handler.setPreProcess (std::bind (&ServerMethods::preProcess, this,
-                                      std::placeholders::_1,
-                                      std::placeholders::_2) );
-    handler.setPostProcess (std::bind (&ServerMethods::postProcess, this,
-                                       std::placeholders::_1,
-                                       std::placeholders::_2) );
+    cache = std::shared_ptr<RequestCache> (new RequestCache (REQUEST_TIMEOUT) );
   } else {
     GST_DEBUG ("Disabling cache");
   }
 
-  handler.addMethod ("connect", std::bind (&ServerMethods::connect, this,
-                     std::placeholders::_1,
-                     std::placeholders::_2) );
-  handler.addMethod ("create", std::bind (&ServerMethods::create, this,
-                                          std::placeholders::_1,
-                                          std::placeholders::_2) );
-  handler.addMethod ("invoke", std::bind (&ServerMethods::invoke, this,
-                                          std::placeholders::_1,
-                                          std::placeholders::_2) );
-  handler.addMethod ("subscribe", std::bind (&ServerMethods::subscribe, this,
-                     std::placeholders::_1,
-                     std::placeholders::_2) );
-  handler.addMethod ("unsubscribe", std::bind (&ServerMethods::unsubscribe,
-                     this, std::placeholders::_1,
-                     std::placeholders::_2) );
-  handler.addMethod ("release", std::bind (&ServerMethods::release,
-                     this, std::placeholders::_1,
-                     std::placeholders::_2) );
-  handler.addMethod ("ref", std::bind (&ServerMethods::ref,
-                                       this, std::placeholders::_1,
-                                       std::placeholders::_2) );
-  handler.addMethod ("unref", std::bind (&ServerMethods::unref,
-                                         this, std::placeholders::_1,
-                                         std::placeholders::_2) );
-  handler.addMethod ("keepAlive", std::bind (&ServerMethods::keepAlive,
-                     this, std::placeholders::_1,
-                     std::placeholders::_2) );
-  handler.addMethod ("describe", std::bind (&ServerMethods::describe,
-                     this, std::placeholders::_1,
-                     std::placeholders::_2) );
-  handler.addMethod ("transaction", std::bind (&ServerMethods::transaction,
-                     this, std::placeholders::_1, std::placeholders::_2) );
-  handler.addMethod ("ping", std::bind (&ServerMethods::ping, this,
-                                        std::placeholders::_1, std::placeholders::_2) );
-  handler.addMethod ("closeSession", std::bind (&ServerMethods::closeSession,
-                     this,
-                     std::placeholders::_1, std::placeholders::_2) );
+  if (!disableObjectCache) {
+    objectCache = std::shared_ptr<ObjectCache> (new ObjectCache (
+                    OBJECT_CACHE_SIZE) );
+  } else {
+    GST_DEBUG ("Disabling object cache");
+  }
+
+  /* Built-in methods are in staticMethods, others are added with addAsyncMethod */
 }
 
 ServerMethods::~ServerMethods()
 {
+  stopResourceMonitor ();
+}
+
+/*
+ * Lookups for optional members. Unlike JsonRpc::getValue they do not throw
+ * when the member is missing, which is the common case for most of them.
+ */
+static const Json::Value *
+findMember (const Json::Value &data, const std::string &name)
+{
+  if (!data.isObject () || !data.isMember (name) ) {
+    return nullptr;
+  }
+
+  return &data[name];
+}
+
+static boost::optional<std::string>
+findString (const Json::Value &data, const std::string &name)
+{
+  const Json::Value *value = findMember (data, name);
+
+  if (value == nullptr
+      || !value->isConvertibleTo (Json::ValueType::stringValue) ) {
+    return boost::none;
+  }
+
+  return value->asString ();
+}
+
+static boost::optional<bool>
+findBool (const Json::Value &data, const std::string &name)
+{
+  const Json::Value *value = findMember (data, name);
+
+  if (value == nullptr
+      || !value->isConvertibleTo (Json::ValueType::booleanValue) ) {
+    return boost::none;
+  }
+
+  return value->asBool ();
 }
 
 static void
@@ -184,54 +248,52 @@ requireParams (const Json::Value &params)
 static bool
 getOrCreateSessionId (std::string &_sessionId, const Json::Value &params)
 {
-  try {
-    JsonRpc::getValue (params, SESSION_ID, _sessionId);
-    return true;
-  } catch (JsonRpc::CallException e) {
+  boost::optional<std::string> sessionId = findString (params, SESSION_ID);
+
+  if (!sessionId) {
     _sessionId = generateUUID ();
     return false;
   }
+
+  _sessionId = *sessionId;
+  return true;
 }
 
-static std::string
+static boost::optional<std::string>
 getSessionId (const Json::Value &resp)
 {
-  std::string sessionId;
-
-  Json::Value result;
+  const Json::Value *result;
 
   if (resp.isMember (JSON_RPC_ERROR) ) {
     /* If response is an error do not return a sessionId */
-    return sessionId;
+    return std::string ();
   }
 
-  JsonRpc::getValue (resp, JSON_RPC_RESULT, result);
-  JsonRpc::getValue (result, SESSION_ID, sessionId);
+  result = findMember (resp, JSON_RPC_RESULT);
 
-  return sessionId;
-}
+  if (result == nullptr) {
+    return boost::none;
+  }
 
+  return findString (*result, SESSION_ID);
+}
 
 static void
 injectSessionId (Json::Value &req, const std::string &sessionId)
 {
-  try {
-    Json::Value params;
-
-    params = req[JSON_RPC_PARAMS];
+  Json::Value *params;
 
-    try {
-      std::string oldSessionId;
+  if (!req.isObject () ) {
+    return;
+  }
 
-      JsonRpc::getValue (params, SESSION_ID, oldSessionId);
-    } catch (JsonRpc::CallException &e) {
-      // There is no sessionId, inject it
-      GST_TRACE ("Injecting sessionId %s", sessionId.c_str() );
-      params[SESSION_ID] = sessionId;
-      req[JSON_RPC_PARAMS] = params;
-    }
-  } catch (JsonRpc::CallException &ex) {
+  params = &req[JSON_RPC_PARAMS];
 
+  if (params->isNull () || (params->isObject ()
+                            && !findString (*params, SESSION_ID) ) ) {
+    // There is no sessionId, inject it
+    GST_TRACE ("Injecting sessionId %s", sessionId.c_str() );
+    (*params) [SESSION_ID] = sessionId;
   }
 }
 
@@ -239,101 +301,845 @@ std::string
 ServerMethods::process (const std::string &requestStr, std::string &responseStr,
                         std::string &sessionId)
 {
+  if (WorkerPool::isWorkerThread () ) {
+    /* The request may need this worker to finish, so it can not block */
+    throw KurentoException (UNEXPECTED_ERROR,
+                            "Synchronous requests can not be processed from a worker thread");
+  }
+
+  /* Shared with the callback, which can outlive this call for an instant */
+  auto result = std::make_shared<std::promise<std::pair<std::string, std::string>>>
+                ();
+  std::future<std::pair<std::string, std::string>> future = result->get_future();
+
+  processAsync (requestStr, sessionId, [result] (const std::string & response,
+  const std::string & newSessionId) {
+    result->set_value (std::make_pair (response, newSessionId) );
+  });
+
+  std::pair<std::string, std::string> value = future.get();
+
+  responseStr = value.first;
+  return value.second;
+}
+
+void
+ServerMethods::processAsync (const std::string &requestStr,
+                             const std::string &sessionId, ResponseCallback callback)
+{
+  processAsync (requestStr, sessionId, Codec::getJsonCodec (), callback);
+}
+
+void
+ServerMethods::processAsync (const std::string &requestStr,
+                             const std::string &sessionId, std::shared_ptr<Codec> codec,
+                             ResponseCallback callback)
+{
+  std::shared_ptr<Json::Value> request;
+  RequestEnvelope envelope;
+  bool scanned = false;
+  std::shared_ptr<CacheEntry> cached;
+  Histogram::Clock::time_point start = Histogram::Clock::now ();
+
+  /* Route cache hits and simple methods without building the whole request */
+  if (codec == Codec::getJsonCodec () ) {
+    scanned = envelope.scan (requestStr);
+  }
+
+  if (scanned) {
+    boost::optional<std::string> requestSessionId = envelope.getSessionId ();
+
+    if (!requestSessionId && !sessionId.empty() ) {
+      /* It will be injected */
+      requestSessionId = sessionId;
+    }
+
+    cached = getCachedResponse (requestSessionId, envelope.getId () );
+
+    if (cached) {
+      callback (cached->getResponse(), cached->getResponseSessionId() );
+      return;
+    }
+
+    if (envelope.getMethod () && !envelope.hasOtherParams ()
+        && CONTROL_METHODS.find (*envelope.getMethod () ) !=
+        CONTROL_METHODS.end () ) {
+      request = std::make_shared<Json::Value> (envelope.toRequest () );
+
+      if (!sessionId.empty() ) {
+        injectSessionId (*request, sessionId);
+      }
+
+      stats->getParse ().recordSince (start);
+      processRequest (request, sessionId, codec, callback);
+      return;
+    }
+  }
+
+  request = std::make_shared<Json::Value> ();
+
+  if (!codec->decode (requestStr, *request) ) {
+    throw JsonRpc::CallException (JsonRpc::ErrorCode::PARSE_ERROR, "Parse error.");
+  }
+
+  stats->getParse ().recordSince (start);
+
+  if (request->isArray () && request->size () > 0) {
+    processBatch (request, sessionId, codec, callback);
+    return;
+  }
+
+  if (scanned && envelope.getId () ) {
+    /* The cache was already checked */
+    if (!sessionId.empty() ) {
+      injectSessionId (*request, sessionId);
+    }
+
+    processRequest (request, sessionId, codec, callback);
+    return;
+  }
+
+  processParsed (request, sessionId, codec, callback);
+}
+
+void
+ServerMethods::processParsed (std::shared_ptr<Json::Value> request,
+                              const std::string &sessionId, std::shared_ptr<Codec> codec,
+                              ResponseCallback callback)
+{
+  const Json::Value *params;
+  boost::optional<std::string> requestSessionId;
+  std::shared_ptr<CacheEntry> cached;
+
+  if (!sessionId.empty() ) {
+    injectSessionId (*request, sessionId);
+  }
+
+  params = findMember (*request, JSON_RPC_PARAMS);
+
+  if (params != nullptr) {
+    requestSessionId = findString (*params, SESSION_ID);
+  }
+
+  cached = getCachedResponse (requestSessionId,
+                              getCacheKey (*request, codec) );
+
+  if (cached) {
+    callback (cached->getResponse(), cached->getResponseSessionId() );
+    return;
+  }
+
+  processRequest (request, sessionId, codec, callback);
+}
+
+struct ServerMethods::BatchState {
+  std::shared_ptr<Json::Value> batch;
+  std::shared_ptr<Codec> codec;
+  std::string sessionId;
+  ResponseCallback callback;
+  std::vector<std::string> responses;
+  std::vector<std::string> sessionIds;
+  std::atomic<size_t> pending;
+};
+
+/*
+ * Requests in a batch are independent, so they run in parallel on the worker
+ * pool. Responses are returned in one array, in the order of the requests,
+ * when the last one finishes.
+ */
+void
+ServerMethods::processBatch (std::shared_ptr<Json::Value> batch,
+                             const std::string &sessionId, std::shared_ptr<Codec> codec,
+                             ResponseCallback callback)
+{
+  std::shared_ptr<BatchState> state (new BatchState() );
+
+  state->batch = batch;
+  state->codec = codec;
+  state->sessionId = sessionId;
+  state->callback = callback;
+  state->responses.resize (batch->size() );
+  state->sessionIds.resize (batch->size() );
+  state->pending = batch->size();
+
+  GST_DEBUG ("Processing batch of %u requests", batch->size() );
+
+  if (workerPool && batch->size() > 1) {
+    for (size_t i = 1; i < batch->size(); i++) {
+      workerPool->post ([this, state, i] () {
+        processBatchItem (state, i);
+      });
+    }
+
+    processBatchItem (state, 0);
+  } else {
+    for (size_t i = 0; i < batch->size(); i++) {
+      processBatchItem (state, i);
+    }
+  }
+}
+
+void
+ServerMethods::processBatchItem (std::shared_ptr<BatchState> state,
+                                 size_t index)
+{
+  /* Shares the ownership of the whole batch */
+  std::shared_ptr<Json::Value> request (state->batch,
+                                        & (*state->batch) [ (Json::ArrayIndex) index]);
+
+  auto finish = [state, index] (const std::string & response,
+  const std::string & sessionId) {
+    std::string responseStr;
+    std::string newSessionId = state->sessionId;
+    std::vector<std::string> responses;
+
+    state->responses[index] = response;
+    state->sessionIds[index] = sessionId;
+
+    if (--state->pending > 0) {
+      return;
+    }
+
+    for (size_t i = 0; i < state->responses.size(); i++) {
+      if (state->sessionIds[i] != state->sessionId) {
+        newSessionId = state->sessionIds[i];
+      }
+
+      if (state->responses[i].empty () ) {
+        /* Notifications are not answered */
+        continue;
+      }
+
+      responses.push_back (std::move (state->responses[i]) );
+    }
+
+    if (!responses.empty () ) {
+      state->codec->encodeArray (responses, responseStr);
+    }
+
+    state->callback (responseStr, newSessionId);
+  };
+
+  try {
+    processParsed (request, state->sessionId, state->codec, finish);
+  } catch (JsonRpc::CallException &e) {
+    Json::Value error;
+    std::string errorStr;
+
+    error[JSON_RPC_PROTO] = JSON_RPC_PROTO_VERSION;
+    error[JSON_RPC_ID] = Json::Value::null;
+    error[JSON_RPC_ERROR][JSON_RPC_ERROR_CODE] = e.getCode ();
+    error[JSON_RPC_ERROR][JSON_RPC_ERROR_MESSAGE] = e.getMessage ();
+    state->codec->encode (error, errorStr);
+    finish (errorStr, state->sessionId);
+  }
+}
+
+void
+ServerMethods::processRequest (std::shared_ptr<Json::Value> request,
+                               const std::string &sessionId, std::shared_ptr<Codec> codec,
+                               ResponseCallback callback)
+{
+  std::string currentSessionId = sessionId;
+
+  resolveAliases (*request);
+
+  if (codec == Codec::getJsonCodec ()
+      && describeSpliced (*request, currentSessionId, callback) ) {
+    return;
+  }
+
+  dispatch (*request, [this, request, currentSessionId, codec,
+  callback] (const Json::Value & response) {
+    finishRequest (*request, response, currentSessionId, codec, callback);
+  });
+}
+
+/*
+ * Builds the response to a request as JsonRpc::Handler does, from the result
+ * of its method or the error it threw
+ */
+static Json::Value
+buildResponse (const Json::Value &request, const Json::Value &result,
+               std::exception_ptr error)
+{
+  const Json::Value *id = findMember (request, JSON_RPC_ID);
   Json::Value response;
-  Json::Value request;
-  bool parse = false;
-  Json::Reader reader;
-  Json::FastWriter writer;
-  std::string newSessionId;
 
-  parse = reader.parse (requestStr, request);
+  if (!error) {
+    if (id == nullptr || id->isNull () ) {
+      /* Notifications are not answered */
+      return Json::Value::null;
+    }
+
+    response[JSON_RPC_PROTO] = JSON_RPC_PROTO_VERSION;
+    response[JSON_RPC_ID] = *id;
+    response[JSON_RPC_RESULT] = result;
+    return response;
+  }
+
+  response[JSON_RPC_PROTO] = JSON_RPC_PROTO_VERSION;
+  response[JSON_RPC_ID] = id != nullptr ? *id : Json::Value::null;
+
+  try {
+    std::rethrow_exception (error);
+  } catch (JsonRpc::CallException &e) {
+    response[JSON_RPC_ERROR][JSON_RPC_ERROR_CODE] = e.getCode ();
+    response[JSON_RPC_ERROR][JSON_RPC_ERROR_MESSAGE] = e.getMessage ();
+
+    if (e.getData () != Json::Value::null) {
+      response[JSON_RPC_ERROR][JSON_RPC_ERROR_DATA] = e.getData ();
+    }
+  } catch (std::exception &e) {
+    response[JSON_RPC_ERROR][JSON_RPC_ERROR_CODE] =
+      JsonRpc::ErrorCode::INTERNAL_ERROR;
+    response[JSON_RPC_ERROR][JSON_RPC_ERROR_MESSAGE] = e.what ();
+  } catch (...) {
+    response[JSON_RPC_ERROR][JSON_RPC_ERROR_CODE] =
+      JsonRpc::ErrorCode::INTERNAL_ERROR;
+    response[JSON_RPC_ERROR][JSON_RPC_ERROR_MESSAGE] = "Unexpected error";
+  }
+
+  return response;
+}
+
+static bool
+isError (const Json::Value &response)
+{
+  return response.isObject () && response.isMember (JSON_RPC_ERROR);
+}
+
+/* In the order of StaticMethodIndex */
+const ServerMethods::StaticMethod ServerMethods::staticMethods[] = {
+  {"connect", &ServerMethods::connect, nullptr},
+  {"create", &ServerMethods::create, nullptr},
+  {"invoke", &ServerMethods::invoke, nullptr},
+  {"subscribe", &ServerMethods::subscribe, nullptr},
+  {"unsubscribe", &ServerMethods::unsubscribe, nullptr},
+  {"release", &ServerMethods::release, nullptr},
+  {"ref", &ServerMethods::ref, nullptr},
+  {"unref", &ServerMethods::unref, nullptr},
+  {"keepAlive", &ServerMethods::keepAlive, nullptr},
+  {"describe", &ServerMethods::describe, nullptr},
+  {"transaction", nullptr, &ServerMethods::transaction},
+  {"ping", &ServerMethods::ping, nullptr},
+  {"closeSession", &ServerMethods::closeSession, nullptr},
+  {"getServerStats", &ServerMethods::getServerStats, nullptr}
+};
+
+enum StaticMethodIndex {
+  CONNECT, CREATE, INVOKE, SUBSCRIBE, UNSUBSCRIBE, RELEASE, REF, UNREF,
+  KEEP_ALIVE, DESCRIBE, TRANSACTION, PING, CLOSE_SESSION, GET_SERVER_STATS,
+  NO_METHOD
+};
+
+/*
+ * Perfect hash of the built-in method names on their length and one
+ * character, so finding one costs a single string comparison
+ */
+static StaticMethodIndex
+hashStaticMethod (const std::string &name)
+{
+  switch (name.size () ) {
+  case 3:
+    return REF;
+
+  case 4:
+    return PING;
+
+  case 5:
+    return UNREF;
+
+  case 6:
+    return name[0] == 'c' ? CREATE : INVOKE;
+
+  case 7:
+    return name[0] == 'c' ? CONNECT : RELEASE;
+
+  case 8:
+    return DESCRIBE;
+
+  case 9:
+    return name[0] == 's' ? SUBSCRIBE : KEEP_ALIVE;
+
+  case 11:
+    return name[0] == 'u' ? UNSUBSCRIBE : TRANSACTION;
+
+  case 12:
+    return CLOSE_SESSION;
+
+  case 14:
+    return GET_SERVER_STATS;
+
+  default:
+    return NO_METHOD;
+  }
+}
+
+std::vector<std::string>
+ServerMethods::getStaticMethodNames ()
+{
+  std::vector<std::string> names;
+
+  for (const StaticMethod &method : staticMethods) {
+    names.push_back (method.name);
+  }
+
+  return names;
+}
+
+const ServerMethods::StaticMethod *
+ServerMethods::findStaticMethod (const std::string &name)
+{
+  StaticMethodIndex index = hashStaticMethod (name);
+
+  if (index == NO_METHOD || name != staticMethods[index].name) {
+    return nullptr;
+  }
+
+  return &staticMethods[index];
+}
+
+/*
+ * Runs the method of a request, calling back with the response. Built-in
+ * methods are called directly, the ones added later are looked up by name.
+ * Asynchronous methods may finish later, the rest are run before this
+ * returns. The request has to be valid until then.
+ */
+void
+ServerMethods::dispatch (const Json::Value &request, DispatchCallback callback)
+{
+  const Json::Value *method;
+  const Json::Value *params;
+  const StaticMethod *staticMethod = nullptr;
+  std::map<std::string, AsyncMethod>::const_iterator it;
+  Histogram::Clock::time_point start = Histogram::Clock::now ();
+  size_t index;
+
+  method = findMember (request, JSON_RPC_METHOD);
+
+  if (method == nullptr || !method->isString ()
+      || findString (request, JSON_RPC_PROTO) != std::string (JSON_RPC_PROTO_VERSION)
+      || ( (staticMethod = findStaticMethod (method->asString () ) ) == nullptr
+           && (it = asyncMethods.find (method->asString () ) ) == asyncMethods.end () ) ) {
+    /* The handler also reports invalid requests */
+    Json::Value response;
+
+    handler.process (request, response);
+    stats->recordMethod (NO_METHOD, start, isError (response) );
+    callback (response);
+    return;
+  }
+
+  params = findMember (request, JSON_RPC_PARAMS);
+  index = staticMethod != nullptr ? staticMethod - staticMethods : NO_METHOD;
+
+  if (staticMethod != nullptr && staticMethod->method != nullptr) {
+    Json::Value result;
+    Json::Value response;
+
+    try {
+      (this->*staticMethod->method) (params != nullptr ? *params :
+                                     Json::Value::null, result);
+      response = buildResponse (request, result, nullptr);
+    } catch (...) {
+      response = buildResponse (request, Json::Value::null,
+                                std::current_exception () );
+    }
+
+    stats->recordMethod (index, start, isError (response) );
+    callback (response);
+    return;
+  }
+
+  std::shared_ptr<std::atomic<bool>> completed (new std::atomic<bool> (false) );
+
+  MethodCompletion completion = [this, &request, callback, completed, index,
+  start] (const Json::Value & result, std::exception_ptr error) {
+    if (completed->exchange (true) ) {
+      GST_WARNING ("Method completed more than once, ignoring");
+      return;
+    }
+
+    stats->recordMethod (index, start, error != nullptr);
+    callback (buildResponse (request, result, error) );
+  };
+
+  try {
+    if (staticMethod != nullptr) {
+      (this->*staticMethod->asyncMethod) (params != nullptr ? *params :
+                                          Json::Value::null, completion);
+    } else {
+      it->second (params != nullptr ? *params : Json::Value::null, completion);
+    }
+  } catch (...) {
+    if (*completed) {
+      /* Thrown by the callback, not by the method */
+      throw;
+    }
+
+    completion (Json::Value::null, std::current_exception () );
+  }
+}
+
+void
+ServerMethods::finishRequest (const Json::Value &request,
+                              const Json::Value &response, const std::string &sessionId,
+                              std::shared_ptr<Codec> codec, ResponseCallback callback)
+{
+  /* Responses are copied by the callback, keep the buffer for the next one */
+  static thread_local std::string responseStr;
+  boost::optional<std::string> newSessionId;
+
+  newSessionId = getSessionId (response);
+
+  if (!newSessionId) {
+    /* The response does not carry a sessionId, keep the current one */
+    newSessionId = sessionId;
+  }
+
+  if (response != Json::Value::null) {
+    Histogram::Clock::time_point start = Histogram::Clock::now ();
+
+    codec->encode (response, responseStr);
+    stats->getSerialize ().recordSince (start);
+    cacheResponse (request, response, responseStr, *newSessionId, codec);
+    callback (responseStr, *newSessionId);
+    recycleBuffer (responseStr);
+  } else {
+    callback (std::string (), *newSessionId);
+  }
+}
+
+void
+ServerMethods::addAsyncMethod (const std::string &name, AsyncMethod method)
+{
+  if (findStaticMethod (name) != nullptr) {
+    GST_WARNING ("Built-in method %s can not be replaced", name.c_str () );
+    return;
+  }
+
+  asyncMethods[name] = method;
+}
+
+bool
+ServerMethods::isPriorityRequest (const std::string &request)
+{
+  RequestEnvelope envelope;
+
+  return envelope.scan (request) && envelope.getMethod ()
+         && CONTROL_METHODS.find (*envelope.getMethod () ) !=
+         CONTROL_METHODS.end ();
+}
+
+/*
+ * The MediaSet does not release a session kept alive before a collector
+ * interval has passed, its cached objects can be used until then
+ */
+void
+ServerMethods::keepAliveMediaSession (const std::string &sessionId)
+{
+  try {
+    MediaSet::getMediaSet()->keepAliveSession (sessionId);
+  } catch (...) {
+    if (objectCache) {
+      objectCache->removeSession (sessionId);
+    }
+
+    throw;
+  }
+
+  if (objectCache) {
+    objectCache->keepAlive (sessionId, MediaSet::getCollectorInterval () );
+  }
+}
+
+void
+ServerMethods::keepAliveSession (const std::string &sessionId)
+{
+  std::shared_ptr<ObjectAliases> aliases;
+
+  keepAliveMediaSession (sessionId);
+
+  aliases = getObjectAliases (sessionId);
+
+  if (aliases) {
+    aliases->touch ();
+  }
+}
+
+std::shared_ptr<ObjectAliases>
+ServerMethods::getObjectAliases (const std::string &sessionId)
+{
+  std::unique_lock<std::mutex> lock (objectAliasesMutex);
+  std::unordered_map<std::string, std::shared_ptr<ObjectAliases>>::iterator it;
+
+  if (objectAliases.empty () ) {
+    return nullptr;
+  }
+
+  it = objectAliases.find (sessionId);
+
+  if (it == objectAliases.end () ) {
+    return nullptr;
+  }
+
+  return it->second;
+}
+
+std::shared_ptr<ObjectAliases>
+ServerMethods::enableObjectAliases (const std::string &sessionId)
+{
+  std::unique_lock<std::mutex> lock (objectAliasesMutex);
+  std::shared_ptr<ObjectAliases> &aliases = objectAliases[sessionId];
+  ObjectAliases::Clock::time_point expired = ObjectAliases::Clock::now () - 2 *
+      MediaSet::getCollectorInterval ();
+
+  if (!aliases) {
+    aliases = std::make_shared<ObjectAliases> ();
+  }
+
+  /*
+   * Connected sessions are kept alive periodically, tables not used for
+   * longer than the MediaSet keeps a session are from sessions already gone
+   */
+  for (auto it = objectAliases.begin (); it != objectAliases.end ();) {
+    if (it->second->getLastUse () < expired) {
+      GST_DEBUG ("Removing object aliases of expired session %s",
+                 it->first.c_str () );
+      it = objectAliases.erase (it);
+    } else {
+      it++;
+    }
+  }
+
+  aliases->touch ();
+
+  return aliases;
+}
+
+void
+ServerMethods::removeObjectAliases (const std::string &sessionId)
+{
+  std::unique_lock<std::mutex> lock (objectAliasesMutex);
+  auto it = objectAliases.find (sessionId);
+
+  if (it == objectAliases.end () ) {
+    return;
+  }
+
+  GST_INFO ("Object aliases saved %" G_GUINT64_FORMAT " bytes to session %s",
+            (guint64) it->second->getSavedBytes (), sessionId.c_str () );
+  objectAliases.erase (it);
+}
+
+/*
+ * Replaces the aliases in the object members of a request by the ids they
+ * stand for. Unknown aliases become ids no object has, so the methods report
+ * the object as not found.
+ */
+void
+ServerMethods::resolveAliases (Json::Value &request)
+{
+  std::shared_ptr<ObjectAliases> aliases;
+  boost::optional<std::string> sessionId;
+  Json::Value *params;
+
+  if (!request.isObject () ) {
+    return;
+  }
+
+  params = const_cast<Json::Value *> (findMember (request, JSON_RPC_PARAMS) );
+
+  if (params == nullptr || !params->isObject () ) {
+    return;
+  }
+
+  sessionId = findString (*params, SESSION_ID);
+
+  if (!sessionId || ! (aliases = getObjectAliases (*sessionId) ) ) {
+    return;
+  }
+
+  auto resolve = [&aliases] (Json::Value & value) {
+    std::string objectId;
+
+    if (!value.isUInt64 () ) {
+      return;
+    }
+
+    if (aliases->getObjectId (value.asUInt64 (), objectId) ) {
+      aliases->addSavedBytes (value.asUInt64 (), objectId);
+      value = objectId;
+    } else {
+      value = std::to_string (value.asUInt64 () );
+    }
+  };
+
+  if (params->isMember (OBJECT) ) {
+    resolve ( (*params) [OBJECT]);
+  }
+
+  if (params->isMember (OBJECTS) && (*params) [OBJECTS].isArray () ) {
+    for (Json::Value &object : (*params) [OBJECTS]) {
+      resolve (object);
+    }
+  }
+}
+
+/* Tells the object alias in the response, if the session uses aliases */
+void
+ServerMethods::addAlias (const std::string &sessionId,
+                         const std::string &objectId, Json::Value &response)
+{
+  std::shared_ptr<ObjectAliases> aliases = getObjectAliases (sessionId);
+
+  if (aliases) {
+    response[ALIAS] = Json::Value::UInt64 (aliases->getAlias (objectId) );
+  }
+}
+
+std::shared_ptr<CacheEntry>
+ServerMethods::getCachedResponse (const boost::optional<std::string>
+                                  &sessionId, const boost::optional<std::string> &requestId)
+{
+  std::shared_ptr<CacheEntry> entry;
+
+  if (!cache || !sessionId || !requestId) {
+    return entry;
+  }
+
+  entry = cache->findCachedResponse (*sessionId, *requestId);
+  stats->recordRequestCache (entry != nullptr);
+
+  if (entry) {
+    GST_DEBUG ("Cached response");
+  }
+
+  return entry;
+}
+
+/*
+ * Responses are cached encoded, so requests sent with other encodings than
+ * JSON text use their own keys
+ */
+boost::optional<std::string>
+ServerMethods::getCacheKey (const Json::Value &request,
+                            std::shared_ptr<Codec> codec)
+{
+  boost::optional<std::string> requestId = findString (request, JSON_RPC_ID);
+
+  if (requestId && codec != Codec::getJsonCodec () ) {
+    requestId = codec->getName () + ":" + *requestId;
+  }
+
+  return requestId;
+}
+
+void
+ServerMethods::cacheResponse (const Json::Value &request,
+                              const Json::Value &response, const std::string &responseStr,
+                              const std::string &responseSessionId, std::shared_ptr<Codec> codec)
+{
+  boost::optional<std::string> sessionId;
+  boost::optional<std::string> requestId;
+  const Json::Value *member;
 
-  if (!parse) {
-    throw JsonRpc::CallException (JsonRpc::ErrorCode::PARSE_ERROR, "Parse error.");
+  if (!cache) {
+    return;
   }
 
-  if (!sessionId.empty() ) {
-    injectSessionId (request, sessionId);
+  requestId = getCacheKey (request, codec);
+
+  if (!requestId) {
+    return;
   }
 
-  handler.process (request, response);
+  member = findMember (response, JSON_RPC_RESULT);
 
-  try {
-    newSessionId = getSessionId (response);
-  } catch (JsonRpc::CallException &ex) {
-    /* We could not get some of the required parameters. Ignore */
-    newSessionId = sessionId;
+  if (member != nullptr) {
+    sessionId = findString (*member, SESSION_ID);
   }
 
-  if (response != Json::Value::null) {
-    responseStr = writer.write (response);
+  if (!sessionId) {
+    member = findMember (request, JSON_RPC_PARAMS);
+
+    if (member != nullptr) {
+      sessionId = findString (*member, SESSION_ID);
+    }
   }
 
-  return newSessionId;
-}
+  if (!sessionId) {
+    /* We could not get some of the required parameters. Ignore */
+    return;
+  }
 
-void
-ServerMethods::keepAliveSession (const std::string &sessionId)
-{
-  MediaSet::getMediaSet()->keepAliveSession (sessionId);
+  GST_LOG ("Caching: %s", responseStr.c_str() );
+  cache->addResponse (*sessionId, *requestId, responseStr, responseSessionId);
 }
 
-bool
-ServerMethods::preProcess (const Json::Value &request, Json::Value &response)
+std::shared_ptr<MediaObjectImpl>
+ServerMethods::getMediaObject (const std::string &sessionId,
+                               const std::string &objectId)
 {
-  std::string sessionId;//   std::string resp;
-  std::string requestId;
-
-  try {
-    Json::Value params;
+  std::shared_ptr<MediaObjectImpl> obj;
 
-    JsonRpc::getValue (request, JSON_RPC_ID, requestId);
-    JsonRpc::getValue (request, JSON_RPC_PARAMS, params);
-    JsonRpc::getValue (params, SESSION_ID, sessionId);
+  if (objectCache) {
+    obj = objectCache->getObject (sessionId, objectId);
+    stats->recordObjectCache (obj != nullptr);
 
-    response = cache->getCachedResponse (sessionId, requestId);
+    if (obj) {
+      return obj;
+    }
+  }
 
-    GST_DEBUG ("Cached response");
+  /* Also references the object from the session, if it was not */
+  obj = MediaSet::getMediaSet()->getMediaObject (sessionId, objectId);
 
-    return false;
-  } catch (...) {
-    /* continue processing */
-    return true;
+  if (objectCache) {
+    objectCache->addObject (sessionId, objectId, obj);
   }
+
+  return obj;
 }
 
-void
-ServerMethods::postProcess (const Json::Value &request, Json::Value &response)
+/*
+ * The type, qualified type and hierarchy of all the objects of a type are the
+ * same, so they are built and serialized once per type.
+ */
+std::shared_ptr<const ServerMethods::TypeDescription>
+ServerMethods::getTypeDescription (std::shared_ptr<MediaObjectImpl> obj)
 {
-  Json::FastWriter writer;
-  std::string sessionId;
-  std::string requestId;
-
-  try {
-    Json::Reader reader;
+  std::string qualifiedType = obj->getQualifiedType();
+  std::shared_ptr<TypeDescription> description;
+  std::string json;
+  std::unique_lock<std::mutex> lock (typeDescriptionsMutex);
+  auto it = typeDescriptions.find (qualifiedType);
+
+  if (it != typeDescriptions.end () ) {
+    return it->second;
+  }
 
-    JsonRpc::getValue (request, JSON_RPC_ID, requestId);
+  lock.unlock ();
 
-    try {
-      Json::Value result;
+  description = std::make_shared<TypeDescription> ();
+  description->value[TYPE] = obj->getType ();
+  description->value[QUALIFIED_TYPE] = qualifiedType;
+  JsonSerializer serializer (true);
+  std::vector <std::string> array = obj->getHierarchy();
+  serializer.Serialize ("array", array);
+  description->value[HIERARCHY]  = serializer.JsonValue["array"];
 
-      JsonRpc::getValue (response, JSON_RPC_RESULT, result);
-      JsonRpc::getValue (result, SESSION_ID, sessionId);
-    } catch (JsonRpc::CallException &ex) {
-      Json::Value params;
+  /* Without the braces, so other members can be added around them */
+  writeJson (description->value, json);
+  description->members = json.substr (1, json.size () - 2);
 
-      JsonRpc::getValue (request, JSON_RPC_PARAMS, params);
-      JsonRpc::getValue (params, SESSION_ID, sessionId);
-    }
+  GST_DEBUG ("Adding description of type %s", qualifiedType.c_str() );
 
-    /* CacheException will be triggered if this response is not cached */
-    cache->getCachedResponse (sessionId, requestId);
-  } catch (JsonRpc::CallException &e) {
-    /* We could not get some of the required parameters. Ignore */
-  } catch (CacheException &e) {
-    GST_LOG ("Caching: %s", response.toStyledString().c_str() );
-    cache->addResponse (sessionId, requestId, response);
-  }
+  lock.lock ();
+  /* Keeps the first one if other thread added it meanwhile */
+  return typeDescriptions.insert (std::make_pair (qualifiedType,
+                                  description) ).first->second;
 }
 
 void
@@ -342,15 +1148,23 @@ ServerMethods::describe (const Json::Value &params, Json::Value &response)
   std::shared_ptr<MediaObjectImpl> obj;
   std::string sessionId;
   std::string objectId;
+  const Json::Value *objects;
 
   requireParams (params);
 
   getOrCreateSessionId (sessionId, params);
 
+  objects = findMember (params, OBJECTS);
+
+  if (objects != nullptr) {
+    describeObjects (*objects, sessionId, response);
+    return;
+  }
+
   JsonRpc::getValue (params, OBJECT, objectId);
 
   try {
-    obj = MediaSet::getMediaSet()->getMediaObject (sessionId, objectId);
+    obj = getMediaObject (sessionId, objectId);
 
   } catch (KurentoException &ex) {
     Json::Value data;
@@ -360,13 +1174,133 @@ ServerMethods::describe (const Json::Value &params, Json::Value &response)
     throw JsonRpc::CallException (ex.getCode (), ex.getMessage (), data);
   }
 
+  response = getTypeDescription (obj)->value;
+  response[SESSION_ID] = sessionId;
+  addAlias (sessionId, objectId, response);
+}
+
+/*
+ * Answers a describe of one object in JSON text splicing the serialized type
+ * description, instead of building and writing it again for every request.
+ * Anything else, including errors, is left to the regular path.
+ *
+ * @returns false if the request was not answered
+ */
+bool
+ServerMethods::describeSpliced (const Json::Value &request,
+                                const std::string &sessionId, ResponseCallback callback)
+{
+  /* Responses are copied by the callback, keep the buffer for the next one */
+  static thread_local std::string responseStr;
+  Histogram::Clock::time_point start = Histogram::Clock::now ();
+  std::shared_ptr<const TypeDescription> description;
+  std::string responseSessionId;
+  boost::optional<std::string> objectId;
+  const Json::Value *params;
+  const Json::Value *id;
+  Json::Value response;
+  Json::Value result;
+  size_t resultStart;
+
+  params = findMember (request, JSON_RPC_PARAMS);
+  id = findMember (request, JSON_RPC_ID);
+
+  if (findString (request, JSON_RPC_METHOD) != std::string ("describe")
+      || findString (request, JSON_RPC_PROTO) !=
+      std::string (JSON_RPC_PROTO_VERSION)
+      || id == nullptr || id->isNull () || params == nullptr
+      || findMember (*params, OBJECTS) != nullptr) {
+    return false;
+  }
+
+  objectId = findString (*params, OBJECT);
+
+  if (!objectId) {
+    return false;
+  }
+
+  getOrCreateSessionId (responseSessionId, *params);
+
+  try {
+    description = getTypeDescription (getMediaObject (responseSessionId,
+                                      *objectId) );
+  } catch (KurentoException &) {
+    return false;
+  }
+
+  result[SESSION_ID] = responseSessionId;
+  addAlias (responseSessionId, *objectId, result);
+
+  response[JSON_RPC_PROTO] = JSON_RPC_PROTO_VERSION;
+  response[JSON_RPC_ID] = *id;
+  stats->recordMethod (DESCRIBE, start, false);
+
+  start = Histogram::Clock::now ();
+  writeJson (response, responseStr);
+  responseStr.pop_back ();
+  responseStr += ",\"" JSON_RPC_RESULT "\":";
+  resultStart = responseStr.size ();
+  appendJson (responseStr, result);
+  responseStr.insert (resultStart + 1, description->members + ",");
+  responseStr += '}';
+  stats->getSerialize ().recordSince (start);
+
+  response[JSON_RPC_RESULT] = result;
+  cacheResponse (request, response, responseStr, responseSessionId,
+                 Codec::getJsonCodec () );
+  callback (responseStr, responseSessionId);
+  recycleBuffer (responseStr);
+
+  return true;
+}
+
+/*
+ * Describes many objects in one call. Objects that can not be found get an
+ * error in their position instead of failing the whole request.
+ */
+void
+ServerMethods::describeObjects (const Json::Value &objects,
+                                const std::string &sessionId, Json::Value &response)
+{
+  if (!objects.isArray () ) {
+    Json::Value data;
+
+    data[TYPE] = "INVALID_PARAMS";
+
+    throw JsonRpc::CallException (JsonRpc::ErrorCode::INVALID_PARAMS,
+                                  "'" OBJECTS "' should be an array", data);
+  }
+
+  response[VALUE] = Json::Value (Json::arrayValue);
+
+  for (const Json::Value &object : objects) {
+    Json::Value description;
+
+    if (!object.isString () ) {
+      description[JSON_RPC_ERROR][JSON_RPC_ERROR_CODE] =
+        JsonRpc::ErrorCode::INVALID_PARAMS;
+      description[JSON_RPC_ERROR][JSON_RPC_ERROR_MESSAGE] =
+        "Object id should be a string";
+      description[OBJECT] = object;
+      response[VALUE].append (description);
+      continue;
+    }
+
+    try {
+      description = getTypeDescription (getMediaObject (sessionId,
+                                        object.asString () ) )->value;
+      addAlias (sessionId, object.asString (), description);
+    } catch (KurentoException &ex) {
+      description[JSON_RPC_ERROR][JSON_RPC_ERROR_CODE] = ex.getCode ();
+      description[JSON_RPC_ERROR][JSON_RPC_ERROR_MESSAGE] = ex.getMessage ();
+      description[JSON_RPC_ERROR][JSON_RPC_ERROR_DATA][TYPE] = ex.getType ();
+    }
+
+    description[OBJECT] = object;
+    response[VALUE].append (description);
+  }
+
   response[SESSION_ID] = sessionId;
-  response[TYPE] = obj->getType ();
-  response[QUALIFIED_TYPE] = obj->getQualifiedType();
-  JsonSerializer serializer (true);
-  std::vector <std::string> array = obj->getHierarchy();
-  serializer.Serialize ("array", array);
-  response[HIERARCHY]  = serializer.JsonValue["array"];
 }
 
 void
@@ -379,7 +1313,7 @@ ServerMethods::keepAlive (const Json::Value &params, Json::Value &response)
   JsonRpc::getValue (params, SESSION_ID, sessionId);
 
   try {
-    MediaSet::getMediaSet()->keepAliveSession (sessionId);
+    keepAliveMediaSession (sessionId);
   } catch (KurentoException &ex) {
     Json::Value data;
 
@@ -396,6 +1330,7 @@ ServerMethods::release (const Json::Value &params, Json::Value &response)
 {
   std::string objectId;
   std::string sessionId;
+  std::shared_ptr<ObjectAliases> aliases;
 
   requireParams (params);
 
@@ -405,6 +1340,16 @@ ServerMethods::release (const Json::Value &params, Json::Value &response)
 
   try {
     MediaSet::getMediaSet()->release (objectId);
+
+    if (objectCache) {
+      objectCache->removeObject (objectId);
+    }
+
+    aliases = getObjectAliases (sessionId);
+
+    if (aliases) {
+      aliases->removeObject (objectId);
+    }
   } catch (KurentoException &ex) {
     Json::Value data;
 
@@ -453,6 +1398,11 @@ ServerMethods::unref (const Json::Value &params, Json::Value &response)
 
   try {
     MediaSet::getMediaSet()->unref (sessionId, objectId);
+
+    /* It is released if no other session references it */
+    if (objectCache) {
+      objectCache->removeObject (objectId);
+    }
   } catch (KurentoException &ex) {
     Json::Value data;
 
@@ -528,7 +1478,7 @@ ServerMethods::subscribe (const Json::Value &params, Json::Value &response)
   getOrCreateSessionId (sessionId, params);
 
   try {
-    obj = MediaSet::getMediaSet()->getMediaObject (sessionId, objectId);
+    obj = getMediaObject (sessionId, objectId);
 
     try {
       handlerId = eventSubscriptionHandler (obj, sessionId, eventType, params);
@@ -560,16 +1510,18 @@ ServerMethods::invoke (const Json::Value &params, Json::Value &response)
   std::string operation;
   Json::Value operationParams;
   std::string objectId;
+  const Json::Value *member;
 
   requireParams (params);
 
   JsonRpc::getValue (params, "operation", operation);
   JsonRpc::getValue (params, OBJECT, objectId);
 
-  try {
-    JsonRpc::getValue (params, "operationParams", operationParams);
-  } catch (JsonRpc::CallException e) {
+  member = findMember (params, "operationParams");
+
+  if (member != nullptr) {
     /* operationParams is optional at this point */
+    operationParams = *member;
   }
 
   getOrCreateSessionId (sessionId, params);
@@ -577,7 +1529,7 @@ ServerMethods::invoke (const Json::Value &params, Json::Value &response)
   try {
     Json::Value value;
 
-    obj = MediaSet::getMediaSet()->getMediaObject (sessionId, objectId);
+    obj = getMediaObject (sessionId, objectId);
 
     if (!obj) {
       throw KurentoException (MEDIA_OBJECT_NOT_FOUND, "Object not found");
@@ -621,6 +1573,11 @@ ServerMethods::connect (const Json::Value &params, Json::Value &response)
     }
   }
 
+  if (findBool (params, OBJECT_ALIASES).value_or (false) ) {
+    enableObjectAliases (sessionId);
+    response[OBJECT_ALIASES] = true;
+  }
+
   response[SESSION_ID] = sessionId;
   response["serverId"] = instanceId;
 }
@@ -637,11 +1594,7 @@ ServerMethods::create (const Json::Value &params,
 
   JsonRpc::getValue (params, TYPE, type);
 
-  try {
-    JsonRpc::getValue (params, SESSION_ID, sessionId);
-  } catch (JsonRpc::CallException e) {
-    sessionId = generateUUID ();
-  }
+  getOrCreateSessionId (sessionId, params);
 
   try {
     factory = moduleManager.getFactory (type);
@@ -655,6 +1608,7 @@ ServerMethods::create (const Json::Value &params,
 
     response[VALUE] = object->getId();
     response[SESSION_ID] = sessionId;
+    addAlias (sessionId, object->getId(), response);
   } catch (KurentoException &ex) {
     Json::Value data;
 
@@ -664,15 +1618,17 @@ ServerMethods::create (const Json::Value &params,
   }
 }
 
-void
-insertResult (Json::Value &value, Json::Value &responses, const int index)
+static void
+insertResult (Json::Value &value, const std::vector<Json::Value> &responses,
+              const int index)
 {
-  try {
-    Json::Value result;
+  const Json::Value *result = nullptr;
 
-    JsonRpc::getValue (responses[index], JSON_RPC_RESULT, result);
-    value = result[VALUE];
-  } catch (JsonRpc::CallException e) {
+  if (index >= 0 && (size_t) index < responses.size() ) {
+    result = findMember (responses[index], JSON_RPC_RESULT);
+  }
+
+  if (result == nullptr) {
     Json::Value data;
 
     KurentoException ke (MALFORMED_TRANSACTION,
@@ -682,63 +1638,269 @@ insertResult (Json::Value &value, Json::Value &responses, const int index)
     data[TYPE] = ke.getType();
 
     GST_ERROR ("Error while inserting new ref value: %s",
-               e.getMessage ().c_str () );
+               ke.getMessage ().c_str () );
     throw JsonRpc::CallException (ke.getCode (), ke.getMessage (), data);
   }
+
+  value = (*result) [VALUE];
 }
 
-void
-injectRefs (Json::Value &params, Json::Value &responses)
+static int
+parseRef (const std::string &ref)
+{
+  try {
+    return stoi (ref);
+  } catch (std::invalid_argument &e) {
+    Json::Value data;
+
+    KurentoException ke (MALFORMED_TRANSACTION,
+                         "Invalid index of newref '" + ref + "'");
+
+    data[TYPE] = ke.getType();
+
+    throw JsonRpc::CallException (ke.getCode (), ke.getMessage (), data);
+  }
+}
+
+/* A newref placeholder in the params of a transaction operation */
+struct NewRef {
+  Json::Value *location;
+  std::string ref;
+  int index;
+  bool valid;
+};
+
+struct TransactionOperation {
+  Json::Value *request;
+  std::vector<NewRef> refs;
+};
+
+/*
+ * Records the location of every newref placeholder in params, so results can
+ * be put in place without walking the params again.
+ */
+static void
+findRefs (Json::Value &params, std::vector<NewRef> &refs)
 {
   if (params.isObject () || params.isArray () ) {
     for (auto it = params.begin(); it != params.end() ; it++) {
-      injectRefs (*it, responses);
+      findRefs (*it, refs);
     }
-  } else if (params.isConvertibleTo (Json::ValueType::stringValue) ) {
-    std::string param = JsonFixes::getString (params);
+  } else if (params.isString () ) {
+    const char *param = params.asCString ();
+
+    if (strncmp (param, NEW_REF.c_str (), NEW_REF.size() ) == 0
+        && param[NEW_REF.size()] != '\0') {
+      NewRef ref;
 
-    if (param.size() > NEW_REF.size()
-        && param.substr (0, NEW_REF.size() ) == NEW_REF) {
-      std::string ref = param.substr (NEW_REF.size() );
+      ref.location = &params;
+      ref.ref = param + NEW_REF.size();
 
       try {
-        int index = stoi (ref);
+        ref.index = parseRef (ref.ref);
+        ref.valid = true;
+      } catch (std::exception &e) {
+        /* Reported when the operation runs, as it was before */
+        ref.index = -1;
+        ref.valid = false;
+      }
 
-        insertResult (params, responses, index);
-      } catch (std::invalid_argument &e) {
-        Json::Value data;
+      refs.push_back (ref);
+    }
+  }
+}
+
+static void
+injectRefs (TransactionOperation &operation,
+            const std::vector<Json::Value> &responses)
+{
+  for (const NewRef &ref : operation.refs) {
+    if (!ref.valid) {
+      /* Throws the error for this reference */
+      parseRef (ref.ref);
+    }
+
+    insertResult (*ref.location, responses, ref.index);
+  }
+}
+
+struct ServerMethods::TransactionState {
+  Json::Value operations;
+  std::string sessionId;
+  std::vector<TransactionOperation> requests;
+  std::vector<Json::Value> responses;
+  std::vector<std::vector<uint>> byLevel;
+  std::atomic<size_t> pending;
+  std::atomic<uint> failed;
+  std::exception_ptr error;
+  uint errorIndex;
+  std::mutex mutex;
+  MethodCompletion completion;
+};
+
+/*
+ * Runs one operation, calling next when it finishes. A failed operation is
+ * recorded in the state instead of stopping the transaction.
+ */
+void
+ServerMethods::runTransactionOperation (std::shared_ptr<TransactionState>
+                                        state, size_t index, std::function<void () > next)
+{
+  TransactionOperation &operation = state->requests[index];
 
-        KurentoException ke (MALFORMED_TRANSACTION,
-                             "Invalid index of newref '" + ref + "'");
+  auto fail = [state, index] () {
+    uint current = state->failed;
+
+    while (index < current
+           && !state->failed.compare_exchange_weak (current, index) ) {
+    }
+  };
 
-        data[TYPE] = ke.getType();
+  try {
+    injectRefs (operation, state->responses);
+  } catch (JsonRpc::CallException &e) {
+    {
+      std::unique_lock<std::mutex> lock (state->mutex);
 
-        throw JsonRpc::CallException (ke.getCode (), ke.getMessage (), data);
+      if (index < state->errorIndex) {
+        state->error = std::current_exception ();
+        state->errorIndex = index;
       }
     }
+
+    fail ();
+    next ();
+    return;
+  }
+
+  resolveAliases (*operation.request);
+
+  dispatch (*operation.request, [state, index, next,
+  fail] (const Json::Value & response) {
+    state->responses[index] = response;
+
+    if (response.isMember (JSON_RPC_ERROR) ) {
+      fail ();
+    }
+
+    next ();
+  });
+}
+
+/* Runs the operations one after the other, stopping after the first failure */
+void
+ServerMethods::runTransactionInOrder (std::shared_ptr<TransactionState>
+                                      state, size_t index)
+{
+  if (index >= state->requests.size() || state->failed < index) {
+    finishTransaction (state);
+    return;
   }
+
+  runTransactionOperation (state, index, [this, state, index] () {
+    runTransactionInOrder (state, index + 1);
+  });
 }
 
+/*
+ * Runs the operations by levels of the dependency graph: an operation runs in
+ * parallel with the others in its level once all the operations it depends
+ * on have finished. No thread waits for a level, the last operation to finish
+ * starts the next one.
+ */
 void
-ServerMethods::transaction (const Json::Value &params, Json::Value &response)
+ServerMethods::runTransactionLevel (std::shared_ptr<TransactionState> state,
+                                    size_t level)
 {
-  std::string sessionId;
-  Json::Value operations;
+  if (level >= state->byLevel.size() ) {
+    finishTransaction (state);
+    return;
+  }
+
+  std::function<void () > next = [this, state, level] () {
+    if (--state->pending == 0) {
+      runTransactionLevel (state, level + 1);
+    }
+  };
+
+  state->pending = state->byLevel[level].size();
+
+  for (uint index : state->byLevel[level]) {
+    workerPool->post ([this, state, index, next] () {
+      if (index > state->failed) {
+        /* It would not have run in order */
+        next ();
+        return;
+      }
+
+      runTransactionOperation (state, index, next);
+    });
+  }
+}
+
+/*
+ * Results are the same as running the operations in order: the ones after the
+ * first failure are dropped, and the objects they created are released.
+ */
+void
+ServerMethods::finishTransaction (std::shared_ptr<TransactionState> state)
+{
+  size_t count = std::min<size_t> (state->failed + 1, state->requests.size() );
+  Json::Value result;
+
+  for (size_t i = count; i < state->requests.size(); i++) {
+    const Json::Value *value = findMember (state->responses[i], JSON_RPC_RESULT);
+
+    if (value == nullptr
+        || (*state->requests[i].request) [JSON_RPC_METHOD] != "create") {
+      continue;
+    }
+
+    try {
+      GST_DEBUG ("Releasing object created after the transaction failed");
+      MediaSet::getMediaSet()->release ( (*value) [VALUE].asString () );
+    } catch (KurentoException &e) {
+      GST_WARNING ("Error releasing object: %s", e.getMessage ().c_str () );
+    }
+  }
+
+  if (state->error && state->errorIndex < count) {
+    state->completion (Json::Value::null, state->error);
+    return;
+  }
+
+  result[VALUE] = Json::Value (Json::arrayValue);
+
+  for (size_t i = 0; i < count; i++) {
+    state->responses[i][JSON_RPC_ID] = (uint) i;
+    result[VALUE].append (state->responses[i]);
+  }
+
+  result[SESSION_ID] = state->sessionId;
+  state->completion (result, nullptr);
+}
+
+void
+ServerMethods::transaction (const Json::Value &params,
+                            MethodCompletion completion)
+{
+  std::shared_ptr<TransactionState> state (new TransactionState() );
+  Json::Value &operations = state->operations;
   std::string uniqueId = generateUUID();
+  std::vector<std::vector<uint>> refs;
+  bool parallel = workerPool != nullptr;
 
   requireParams (params);
 
-  getOrCreateSessionId (sessionId, params);
+  getOrCreateSessionId (state->sessionId, params);
 
   JsonRpc::getArray (params, "operations", operations);
-  Json::Value responses;
 
+  /* Operations are not restructured from here, so ref locations are valid */
   for (uint i = 0; i < operations.size(); i++) {
-    bool ret;
-
     Json::Value &reqParams = operations[i][JSON_RPC_PARAMS];
 
-    reqParams[SESSION_ID] = sessionId;
+    reqParams[SESSION_ID] = state->sessionId;
 
     if (!operations[i][JSON_RPC_ID].isConvertibleTo (Json::ValueType::uintValue)
         || operations[i][JSON_RPC_ID].asUInt() != i) {
@@ -753,41 +1915,56 @@ ServerMethods::transaction (const Json::Value &params, Json::Value &response)
       throw JsonRpc::CallException (ke.getCode (), ke.getMessage (), data);
     }
 
-    try {
-      operations[i][JSON_RPC_ID] = uniqueId + "_" + std::to_string (
-                                     operations[i][JSON_RPC_ID].asUInt() );
-    } catch (...) {
-      GST_ERROR ("Error setting id");
-    }
-
-    injectRefs (reqParams, responses);
+    operations[i][JSON_RPC_ID] = uniqueId + "_" + std::to_string (i);
+  }
 
-    ret = handler.process (operations[i], responses[i]);
+  state->requests.resize (operations.size() );
+  refs.resize (operations.size() );
 
-    responses[i][JSON_RPC_ID] = i;
+  for (uint i = 0; i < operations.size(); i++) {
+    TransactionOperation &operation = state->requests[i];
+
+    operation.request = &operations[i];
+    /* Object ids are needed to find the dependencies */
+    resolveAliases (*operation.request);
+    findRefs ( (*operation.request) [JSON_RPC_PARAMS], operation.refs);
+
+    for (const NewRef &ref : operation.refs) {
+      if (!ref.valid || ref.index < 0 || (uint) ref.index >= i) {
+        /* Run in order, to report the error where it was reported before */
+        parallel = false;
+        break;
+      }
 
-    if (!ret) {
-      break;
+      refs[i].push_back (ref.index);
     }
   }
 
-  if (responses.isNull () ) {
-    responses.resize (0);
+  if (parallel) {
+    state->byLevel = getTransactionLevels (operations, refs);
   }
 
-  response[VALUE] = responses;
-  response[SESSION_ID] = sessionId;
+  state->responses.resize (operations.size() );
+  state->failed = operations.size();
+  state->errorIndex = operations.size();
+  state->completion = completion;
+
+  if (parallel && operations.size() > 1) {
+    runTransactionLevel (state, 0);
+  } else {
+    runTransactionInOrder (state, 0);
+  }
 }
 
 void
 ServerMethods::ping (const Json::Value &params, Json::Value &response)
 {
+  boost::optional<std::string> found = findString (params, SESSION_ID);
   std::string sessionId;
 
-  try {
-    JsonRpc::getValue (params, SESSION_ID, sessionId);
+  if (found) {
+    sessionId = *found;
     response [SESSION_ID] = sessionId;
-  } catch (JsonRpc::CallException e) {
   }
 
   if (sessionId.empty()) {
@@ -800,28 +1977,105 @@ ServerMethods::ping (const Json::Value &params, Json::Value &response)
   response[VALUE] = "pong";
 }
 
+void
+ServerMethods::collectServerStats (Json::Value &value)
+{
+  stats->getStats (value);
+
+  if (workerPool) {
+    ServerStats::getHistogramStats (workerPool->getQueueDelays (
+                                      WorkerPool::Lane::NORMAL), value["phases"]["queue"]);
+    ServerStats::getHistogramStats (workerPool->getQueueDelays (
+                                      WorkerPool::Lane::PRIORITY), value["phases"]["priorityQueue"]);
+  }
+
+  value["sessions"] = (Json::UInt) serverManager->getSessions ().size ();
+  value["connections"] = connections.load ();
+  value["objectAliasSavedBytes"] = Json::UInt64 (
+                                     ObjectAliases::getTotalSavedBytes () );
+
+  std::shared_ptr<const ResourceUsage> usage = getResourceUsage ();
+  Json::Value &resources = value["resources"];
+
+  resources["threads"] = usage->threads;
+  resources["maxThreads"] = usage->maxThreads;
+  resources["openFiles"] = usage->openFiles;
+  resources["maxOpenFiles"] = usage->maxOpenFiles;
+  resources["rssBytes"] = Json::UInt64 (usage->rssBytes);
+  resources["cpuPercent"] = usage->cpuPercent;
+  resources["sampleAgeMs"] = Json::Int64 (
+                               std::chrono::duration_cast<std::chrono::milliseconds>
+                               (std::chrono::steady_clock::now () - usage->sampled).count () );
+
+  CompressionStats::getStats (value["compression"]);
+  WriteStats::getStats (value["writes"]);
+}
+
+void
+ServerMethods::getServerStats (const Json::Value &params,
+                               Json::Value &response)
+{
+  boost::optional<std::string> sessionId = findString (params, SESSION_ID);
+
+  collectServerStats (response[VALUE]);
+
+  if (sessionId) {
+    response[SESSION_ID] = *sessionId;
+  }
+}
+
+void
+ServerMethods::logServerStats ()
+{
+  Json::Value value;
+  std::string valueStr;
+
+  collectServerStats (value);
+  writeJson (value, valueStr);
+
+  GST_INFO ("Server stats: %s", valueStr.c_str () );
+}
+
+void
+ServerMethods::connectionOpened ()
+{
+  connections++;
+}
+
+void
+ServerMethods::connectionClosed ()
+{
+  connections--;
+}
+
 void
 ServerMethods::closeSession (const Json::Value &params,
                              Json::Value &response)
 {
   std::string sessionId;
-  bool release = false;
+  /* release param is optional*/
+  bool release = findBool (params, "release").value_or (false);
 
   requireParams (params);
 
-  try {
-    JsonRpc::getValue (params, "release", release);
-  } catch (JsonRpc::CallException e) {
-    /* release param is optional*/
-  }
-
   JsonRpc::getValue (params, SESSION_ID, sessionId);
 
   if (release) {
     MediaSet::getMediaSet()->releaseSession (sessionId);
+
+    /* Objects of the session may be cached for other sessions */
+    if (objectCache) {
+      objectCache->clear ();
+    }
   } else {
     MediaSet::getMediaSet()->unrefSession (sessionId);
+
+    if (objectCache) {
+      objectCache->removeSession (sessionId);
+    }
   }
+
+  removeObjectAliases (sessionId);
 }
 
 ServerMethods::StaticConstructor ServerMethods::staticConstructor;
@@ -22,13 +22,22 @@
 #include <EventHandler.hpp>
 #include <ModuleManager.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <boost/optional.hpp>
 #include <Processor.hpp>
+#include <mutex>
+#include <unordered_map>
 #include "RequestCache.hpp"
+#include "WorkerPool.hpp"
+
+#include <atomic>
 
 namespace kurento
 {
 
 class MediaObject;
+class ObjectCache;
+class ServerManagerImpl;
+class ServerStats;
 
 class ServerMethods : public Processor
 {
@@ -37,11 +46,64 @@ public:
   ServerMethods (const boost::property_tree::ptree &config);
   virtual ~ServerMethods();
 
+  /**
+   * Process the request, blocking until it finishes. It must not be called
+   * from a worker thread, as the request may need the workers to finish; use
+   * processAsync there instead.
+   */
   virtual std::string process (const std::string &request, std::string &response,
                                std::string &sessionId);
 
+  virtual void processAsync (const std::string &request,
+                             const std::string &sessionId, ResponseCallback callback);
+
+  virtual void processAsync (const std::string &request,
+                             const std::string &sessionId, std::shared_ptr<Codec> codec,
+                             ResponseCallback callback);
+
   virtual void keepAliveSession (const std::string &sessionId);
 
+  virtual bool isPriorityRequest (const std::string &request);
+
+  virtual std::shared_ptr<ObjectAliases> getObjectAliases (
+    const std::string &sessionId);
+
+  virtual void connectionOpened ();
+  virtual void connectionClosed ();
+
+  /**
+   * Write the result of getServerStats to the log
+   */
+  void logServerStats ();
+
+  virtual std::shared_ptr<Executor> getExecutor ()
+  {
+    return workerPool;
+  }
+
+  /**
+   * Called once when an asynchronous method finishes, from any thread
+   *
+   * @param result The result of the method, ignored if there is an error
+   * @param error The error, usually a JsonRpc::CallException, or nullptr
+   */
+  typedef std::function<void (const Json::Value &result,
+                              std::exception_ptr error) > MethodCompletion;
+
+  /**
+   * A method that does not block the calling thread until it finishes. params
+   * are valid until the completion is called.
+   */
+  typedef std::function<void (const Json::Value &params,
+                              MethodCompletion completion) > AsyncMethod;
+
+  /**
+   * Register a method that completes asynchronously, for instance from a
+   * GStreamer or GLib callback. Methods have to be added before requests are
+   * processed, built-in methods can not be replaced.
+   */
+  void addAsyncMethod (const std::string &name, AsyncMethod method);
+
 protected:
 
   virtual std::string connectEventHandler (std::shared_ptr<MediaObjectImpl> obj,
@@ -62,8 +124,79 @@ protected:
 
 private:
 
-  bool preProcess (const Json::Value &request, Json::Value &response);
-  void postProcess (const Json::Value &request, Json::Value &response);
+  typedef std::function<void (const Json::Value &response) > DispatchCallback;
+
+  typedef void (ServerMethods::*Method) (const Json::Value &params,
+                                         Json::Value &response);
+  typedef void (ServerMethods::*AsyncMemberMethod) (const Json::Value &params,
+      MethodCompletion completion);
+
+  /* A built-in method, either synchronous or asynchronous */
+  struct StaticMethod {
+    const char *name;
+    Method method;
+    AsyncMemberMethod asyncMethod;
+  };
+
+  static const StaticMethod staticMethods[];
+  static const StaticMethod *findStaticMethod (const std::string &name);
+  static std::vector<std::string> getStaticMethodNames ();
+
+  struct BatchState;
+  struct TransactionState;
+
+  /* Description shared by all the objects of a type */
+  struct TypeDescription {
+    Json::Value value;
+    /* The members of value already written as JSON, without the braces */
+    std::string members;
+  };
+
+  void processParsed (std::shared_ptr<Json::Value> request,
+                      const std::string &sessionId, std::shared_ptr<Codec> codec,
+                      ResponseCallback callback);
+  void processBatch (std::shared_ptr<Json::Value> batch,
+                     const std::string &sessionId, std::shared_ptr<Codec> codec,
+                     ResponseCallback callback);
+  void processBatchItem (std::shared_ptr<BatchState> state, size_t index);
+  void processRequest (std::shared_ptr<Json::Value> request,
+                       const std::string &sessionId, std::shared_ptr<Codec> codec,
+                       ResponseCallback callback);
+  void dispatch (const Json::Value &request, DispatchCallback callback);
+  void finishRequest (const Json::Value &request, const Json::Value &response,
+                      const std::string &sessionId, std::shared_ptr<Codec> codec,
+                      ResponseCallback callback);
+  std::shared_ptr<CacheEntry> getCachedResponse (const
+      boost::optional<std::string> &sessionId,
+      const boost::optional<std::string> &requestId);
+  boost::optional<std::string> getCacheKey (const Json::Value &request,
+      std::shared_ptr<Codec> codec);
+  void cacheResponse (const Json::Value &request, const Json::Value &response,
+                      const std::string &responseStr, const std::string &responseSessionId,
+                      std::shared_ptr<Codec> codec);
+  std::shared_ptr<MediaObjectImpl> getMediaObject (const std::string &sessionId,
+      const std::string &objectId);
+  void keepAliveMediaSession (const std::string &sessionId);
+  std::shared_ptr<const TypeDescription> getTypeDescription (
+    std::shared_ptr<MediaObjectImpl> obj);
+  bool describeSpliced (const Json::Value &request,
+                        const std::string &sessionId, ResponseCallback callback);
+  void describeObjects (const Json::Value &objects, const std::string &sessionId,
+                        Json::Value &response);
+  std::shared_ptr<ObjectAliases> enableObjectAliases (const std::string
+      &sessionId);
+  void removeObjectAliases (const std::string &sessionId);
+  void resolveAliases (Json::Value &request);
+  void addAlias (const std::string &sessionId, const std::string &objectId,
+                 Json::Value &response);
+
+  void runTransactionInOrder (std::shared_ptr<TransactionState> state,
+                              size_t index);
+  void runTransactionLevel (std::shared_ptr<TransactionState> state,
+                            size_t level);
+  void runTransactionOperation (std::shared_ptr<TransactionState> state,
+                                size_t index, std::function<void () > next);
+  void finishTransaction (std::shared_ptr<TransactionState> state);
 
   void connect (const Json::Value &params, Json::Value &response);
   void create (const Json::Value &params, Json::Value &response);
@@ -75,12 +208,15 @@ private:
   void unref (const Json::Value &params, Json::Value &response);
   void keepAlive (const Json::Value &params, Json::Value &response);
   void describe (const Json::Value &params, Json::Value &response);
-  void transaction (const Json::Value &params, Json::Value &response);
+  void transaction (const Json::Value &params, MethodCompletion completion);
   void ping (const Json::Value &params, Json::Value &response);
+  void getServerStats (const Json::Value &params, Json::Value &response);
+  void collectServerStats (Json::Value &value);
   void closeSession (const Json::Value &params, Json::Value &response);
 
   const boost::property_tree::ptree &config;
   JsonRpc::Handler handler;
+  std::map<std::string, AsyncMethod> asyncMethods;
 
   float resourceLimitPercent;
 
@@ -89,6 +225,17 @@ private:
 
   ModuleManager &moduleManager;
   std::shared_ptr<RequestCache> cache;
+  std::shared_ptr<ObjectCache> objectCache;
+  std::unordered_map<std::string, std::shared_ptr<const TypeDescription>>
+      typeDescriptions;
+  std::mutex typeDescriptionsMutex;
+  std::unordered_map<std::string, std::shared_ptr<ObjectAliases>>
+      objectAliases;
+  std::mutex objectAliasesMutex;
+  std::shared_ptr<WorkerPool> workerPool;
+  std::shared_ptr<ServerManagerImpl> serverManager;
+  std::shared_ptr<ServerStats> stats;
+  std::atomic<int> connections;
   std::string instanceId;
 
   class StaticConstructor
@@ -0,0 +1,127 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "ServerStats.hpp"
+
+#include <algorithm>
+
+namespace kurento
+{
+
+ServerStats::ServerStats (const std::vector<std::string> &methods) :
+  started (std::chrono::steady_clock::now () )
+{
+  for (const std::string &name : methods) {
+    this->methods.push_back (std::unique_ptr<MethodStats> (new MethodStats () ) );
+    this->methods.back ()->name = name;
+  }
+
+  this->methods.push_back (std::unique_ptr<MethodStats> (new MethodStats () ) );
+  this->methods.back ()->name = "other";
+}
+
+void
+ServerStats::recordMethod (size_t method, Histogram::Clock::time_point start,
+                           bool error)
+{
+  MethodStats &stats = *methods[std::min (method, methods.size () - 1)];
+
+  stats.count.add ();
+  stats.latency.recordSince (start);
+
+  if (error) {
+    stats.errors.add ();
+  }
+}
+
+void
+ServerStats::recordRequestCache (bool hit)
+{
+  if (hit) {
+    requestCacheHits.add ();
+  } else {
+    requestCacheMisses.add ();
+  }
+}
+
+void
+ServerStats::recordObjectCache (bool hit)
+{
+  if (hit) {
+    objectCacheHits.add ();
+  } else {
+    objectCacheMisses.add ();
+  }
+}
+
+static void
+getCacheStats (uint64_t hits, uint64_t misses, Json::Value &value)
+{
+  value["hits"] = Json::UInt64 (hits);
+  value["misses"] = Json::UInt64 (misses);
+  value["hitRatio"] = hits + misses > 0 ? (double) hits / (hits + misses) : 0;
+}
+
+void
+ServerStats::getHistogramStats (const Histogram::Snapshot &snapshot,
+                                Json::Value &value)
+{
+  value["count"] = Json::UInt64 (snapshot.count);
+  value["mean"] = snapshot.mean ();
+  value["max"] = Json::UInt64 (snapshot.max);
+  value["p50"] = Json::UInt64 (snapshot.percentile (0.5) );
+  value["p90"] = Json::UInt64 (snapshot.percentile (0.9) );
+  value["p99"] = Json::UInt64 (snapshot.percentile (0.99) );
+  value["p999"] = Json::UInt64 (snapshot.percentile (0.999) );
+}
+
+void
+ServerStats::getStats (Json::Value &value)
+{
+  Histogram::Snapshot handler;
+
+  value["uptime"] = Json::UInt64 (std::chrono::duration_cast<std::chrono::seconds>
+                                  (std::chrono::steady_clock::now () - started).count () );
+
+  value["methods"] = Json::Value (Json::objectValue);
+
+  for (const std::unique_ptr<MethodStats> &method : methods) {
+    Histogram::Snapshot latency = method->latency.getSnapshot ();
+
+    if (latency.count == 0) {
+      continue;
+    }
+
+    Json::Value &stats = value["methods"][method->name];
+
+    stats["count"] = Json::UInt64 (method->count.get () );
+    stats["errors"] = Json::UInt64 (method->errors.get () );
+    getHistogramStats (latency, stats["latency"]);
+    handler.merge (latency);
+  }
+
+  getHistogramStats (parse.getSnapshot (), value["phases"]["parse"]);
+  getHistogramStats (handler, value["phases"]["handler"]);
+  getHistogramStats (serialize.getSnapshot (), value["phases"]["serialize"]);
+
+  getCacheStats (requestCacheHits.get (), requestCacheMisses.get (),
+                 value["requestCache"]);
+  getCacheStats (objectCacheHits.get (), objectCacheMisses.get (),
+                 value["objectCache"]);
+}
+
+} /* kurento */
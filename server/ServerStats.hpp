@@ -0,0 +1,94 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __SERVER_STATS_HPP__
+#define __SERVER_STATS_HPP__
+
+#include "Metrics.hpp"
+
+#include <json/json.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kurento
+{
+
+/**
+ * Request processing statistics of the server. Latencies are recorded in
+ * microseconds.
+ */
+class ServerStats
+{
+public:
+  /**
+   * @param methods Names of the methods tracked separately, the rest are
+   *                added to an additional "other" entry
+   */
+  ServerStats (const std::vector<std::string> &methods);
+  ~ServerStats () {};
+
+  /**
+   * @param method Index of the method in the constructor list, or any other
+   *               value for the rest of methods
+   */
+  void recordMethod (size_t method, Histogram::Clock::time_point start,
+                     bool error);
+
+  Histogram &getParse ()
+  {
+    return parse;
+  }
+
+  Histogram &getSerialize ()
+  {
+    return serialize;
+  }
+
+  void recordRequestCache (bool hit);
+  void recordObjectCache (bool hit);
+
+  /**
+   * Adds the recorded statistics to value
+   */
+  void getStats (Json::Value &value);
+
+  static void getHistogramStats (const Histogram::Snapshot &snapshot,
+                                 Json::Value &value);
+
+private:
+  struct MethodStats {
+    std::string name;
+    Counter count;
+    Counter errors;
+    Histogram latency;
+  };
+
+  std::vector<std::unique_ptr<MethodStats>> methods;
+  Histogram parse;
+  Histogram serialize;
+  Counter requestCacheHits;
+  Counter requestCacheMisses;
+  Counter objectCacheHits;
+  Counter objectCacheMisses;
+  std::chrono::steady_clock::time_point started;
+};
+
+} /* kurento */
+
+#endif /* __SERVER_STATS_HPP__ */
@@ -0,0 +1,125 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "TransactionGraph.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+
+#include <jsonrpc/JsonRpcConstants.hpp>
+
+#define SESSION_ID "sessionId"
+#define TYPE "type"
+#define OPERATION "operation"
+
+namespace kurento
+{
+
+static const std::string NEW_REF = "newref:";
+
+/* Params of the methods that hold names instead of object ids */
+static const std::set<std::string> NAME_PARAMS = {SESSION_ID, TYPE, OPERATION};
+
+/*
+ * Adds the pipelines of the object ids found in value. Children ids start
+ * with the id of their pipeline and a slash. Strings that are not ids only
+ * add needless ordering between operations.
+ */
+static void
+findPipelines (const Json::Value &value, std::set<std::string> &pipelines,
+               bool params)
+{
+  if (value.isObject () || value.isArray () ) {
+    for (auto it = value.begin(); it != value.end() ; it++) {
+      if (params && NAME_PARAMS.find (it.name () ) != NAME_PARAMS.end () ) {
+        continue;
+      }
+
+      findPipelines (*it, pipelines, false);
+    }
+  } else if (value.isString () ) {
+    std::string id = value.asString ();
+
+    if (id.compare (0, NEW_REF.size (), NEW_REF) != 0) {
+      pipelines.insert (id.substr (0, id.find ('/') ) );
+    }
+  }
+}
+
+std::vector<std::vector<unsigned int>>
+getTransactionLevels (const Json::Value &operations,
+                      const std::vector<std::vector<unsigned int>> &refs)
+{
+  std::vector<std::vector<unsigned int>> byLevel;
+  /* Pipelines of the objects used by each operation, or of the one created */
+  std::vector<std::set<std::string>> pipelines (operations.size() );
+  std::vector<unsigned int> levels (operations.size() );
+  /* Level of the last operation changing the objects of each pipeline */
+  std::map<std::string, unsigned int> lastChange;
+  unsigned int maxLevel = 0;
+
+  for (unsigned int i = 0; i < operations.size(); i++) {
+    const Json::Value &operation = operations[i];
+    bool create = operation[JSON_RPC_METHOD] == "create";
+    unsigned int level = 0;
+
+    findPipelines (operation[JSON_RPC_PARAMS], pipelines[i], true);
+
+    for (unsigned int ref : refs[i]) {
+      level = std::max (level, levels[ref] + 1);
+      pipelines[i].insert (pipelines[ref].begin(), pipelines[ref].end() );
+    }
+
+    if (create && pipelines[i].empty () ) {
+      /* A new pipeline, known by its operation until it exists */
+      pipelines[i].insert (NEW_REF + std::to_string (i) );
+    }
+
+    for (const std::string &pipeline : pipelines[i]) {
+      auto last = lastChange.find (pipeline);
+
+      if (last != lastChange.end () ) {
+        level = std::max (level, last->second + 1);
+      }
+    }
+
+    if (!create) {
+      if (i > 0) {
+        level = std::max (level, maxLevel + 1);
+      }
+
+      for (const std::string &pipeline : pipelines[i]) {
+        lastChange[pipeline] = level;
+      }
+    }
+
+    levels[i] = level;
+    maxLevel = std::max (maxLevel, level);
+
+    if (level >= byLevel.size() ) {
+      byLevel.resize (level + 1);
+    }
+
+    byLevel[level].push_back (i);
+  }
+
+  return byLevel;
+}
+
+} /* kurento */
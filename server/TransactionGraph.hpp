@@ -0,0 +1,49 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __TRANSACTION_GRAPH_HPP__
+#define __TRANSACTION_GRAPH_HPP__
+
+#include <vector>
+#include <json/json.h>
+
+namespace kurento
+{
+
+/**
+ * Groups the operations of a transaction by levels of their dependency
+ * graph. An operation depends on:
+ * - The operations whose results it references with newrefs.
+ * - The last earlier operation other than a create using an object of the
+ *   same pipelines, as it can change or release the objects it acts on.
+ * - If it is not a create, every earlier operation. Its effects can not be
+ *   undone, so it must not run when an earlier one failed.
+ *
+ * Operations only depend on operations of earlier levels, so the ones in a
+ * level can run in parallel.
+ *
+ * @param operations The operations of the transaction
+ * @param refs The indexes of the earlier operations referenced by each one
+ * @returns The indexes of the operations in each level
+ */
+std::vector<std::vector<unsigned int>> getTransactionLevels (
+    const Json::Value &operations,
+    const std::vector<std::vector<unsigned int>> &refs);
+
+} /* kurento */
+
+#endif /* __TRANSACTION_GRAPH_HPP__ */
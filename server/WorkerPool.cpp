@@ -0,0 +1,422 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "WorkerPool.hpp"
+#include <gst/gst.h>
+
+#define GST_CAT_DEFAULT kurento_worker_pool
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+#define GST_DEFAULT_NAME "KurentoWorkerPool"
+
+#define STRAND_SHARDS 64
+#define STRAND_BATCH 16
+
+namespace kurento
+{
+
+/* Pool and queue owned by the current thread, if it is a worker */
+static thread_local WorkerPool *currentPool = nullptr;
+static thread_local unsigned int currentIndex = 0;
+
+WorkerPool::WorkerPool (unsigned int nThreads) : next (0), pending (0),
+  idle (0), running (true), priorityPending (0)
+{
+  if (nThreads < 1) {
+    nThreads = 1;
+  }
+
+  for (unsigned int i = 0; i < nThreads; i++) {
+    workers.push_back (std::unique_ptr<Worker> (new Worker () ) );
+  }
+
+  for (unsigned int i = 0; i < STRAND_SHARDS; i++) {
+    strandShards.push_back (std::unique_ptr<StrandShard> (new StrandShard () ) );
+  }
+
+  for (unsigned int i = 0; i < nThreads; i++) {
+    workers[i]->thread = std::thread (std::bind (&WorkerPool::run, this, i) );
+  }
+
+  priorityThread = std::thread (std::bind (&WorkerPool::runPriority, this) );
+
+  GST_INFO ("Worker pool started with %d threads", nThreads);
+}
+
+WorkerPool::~WorkerPool() throw ()
+{
+  stop ();
+}
+
+void
+WorkerPool::post (std::function<void ()> task)
+{
+  unsigned int index;
+
+  if (currentPool == this) {
+    /* Workers may still queue follow-up tasks while the pool drains */
+    index = currentIndex;
+  } else if (!running) {
+    GST_WARNING ("Worker pool stopped, discarding task");
+    return;
+  } else {
+    index = next++ % workers.size();
+  }
+
+  pending++;
+
+  std::unique_lock<std::mutex> lock (workers[index]->mutex);
+  workers[index]->tasks.push_back (std::move (task) );
+  lock.unlock ();
+
+  if (idle > 0) {
+    std::unique_lock<std::mutex> lock (mutex);
+    cond.notify_one ();
+  }
+}
+
+void
+WorkerPool::post (const std::string &key, std::function<void ()> task)
+{
+  postStrand (key, QueuedTask {std::move (task), Clock::now(), nullptr} );
+}
+
+void
+WorkerPool::postAsync (const std::string &key,
+                       std::function<void (std::function<void ()>) > task)
+{
+  postStrand (key, QueuedTask {nullptr, Clock::now(), std::move (task)} );
+}
+
+void
+WorkerPool::postStrand (const std::string &key, QueuedTask task)
+{
+  StrandShard &shard = *strandShards[std::hash<std::string> () (key) %
+                                     strandShards.size()];
+  std::shared_ptr<Strand> strand;
+
+  if (!running && currentPool != this) {
+    /* Checked first, the strand would stay scheduled with nothing to run it */
+    GST_WARNING ("Worker pool stopped, discarding task");
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock (shard.mutex);
+
+  strand = shard.strands[key];
+
+  if (!strand) {
+    strand = std::make_shared<Strand> ();
+    shard.strands[key] = strand;
+  }
+
+  strand->tasks.push_back (std::move (task) );
+
+  if (strand->scheduled) {
+    return;
+  }
+
+  strand->scheduled = true;
+  lock.unlock ();
+
+  post (std::bind (&WorkerPool::runStrand, this, std::ref (shard), key,
+                   strand) );
+}
+
+void
+WorkerPool::runStrand (StrandShard &shard, const std::string &key,
+                       std::shared_ptr<Strand> strand)
+{
+  /* Run a few tasks and requeue, so a busy session can not hog a worker */
+  for (int i = 0; i < STRAND_BATCH; i++) {
+    QueuedTask task;
+    std::unique_lock<std::mutex> lock (shard.mutex);
+
+    if (strand->tasks.empty () ) {
+      strand->scheduled = false;
+      shard.strands.erase (key);
+      return;
+    }
+
+    task = std::move (strand->tasks.front () );
+    recordDelay (Lane::NORMAL, task.queued);
+    strand->tasks.pop_front ();
+    lock.unlock ();
+
+    if (task.asyncFn) {
+      /* The strand stays scheduled, done resumes it */
+      std::shared_ptr<std::atomic<bool>> finished (new std::atomic<bool> (false) );
+      std::function<void ()> done = [this, &shard, key, strand, finished] () {
+        if (!finished->exchange (true) ) {
+          post (std::bind (&WorkerPool::runStrand, this, std::ref (shard), key,
+                           strand) );
+        }
+      };
+
+      try {
+        task.asyncFn (done);
+      } catch (std::exception &e) {
+        GST_ERROR ("Unexpected error while running task: %s", e.what() );
+        done ();
+      } catch (...) {
+        GST_ERROR ("Unexpected error while running task");
+        done ();
+      }
+
+      return;
+    }
+
+    try {
+      task.fn ();
+    } catch (std::exception &e) {
+      GST_ERROR ("Unexpected error while running task: %s", e.what() );
+    } catch (...) {
+      GST_ERROR ("Unexpected error while running task");
+    }
+  }
+
+  post (std::bind (&WorkerPool::runStrand, this, std::ref (shard), key,
+                   strand) );
+}
+
+void
+WorkerPool::postPriority (std::function<void ()> task)
+{
+  if (!running) {
+    GST_WARNING ("Worker pool stopped, discarding task");
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock (priorityMutex);
+  priorityTasks.push_back (QueuedTask {std::move (task), Clock::now()} );
+  priorityPending++;
+  priorityCond.notify_one ();
+}
+
+bool
+WorkerPool::popPriority (std::function<void ()> &task)
+{
+  if (priorityPending == 0) {
+    /* Avoid the lock in the common case */
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock (priorityMutex);
+
+  if (priorityTasks.empty () ) {
+    return false;
+  }
+
+  task = std::move (priorityTasks.front ().fn);
+  recordDelay (Lane::PRIORITY, priorityTasks.front ().queued);
+  priorityTasks.pop_front ();
+  priorityPending--;
+
+  return true;
+}
+
+void
+WorkerPool::recordDelay (Lane lane, Clock::time_point queued)
+{
+  laneDelays[static_cast<int> (lane)].recordSince (queued);
+}
+
+WorkerPool::QueueStats
+WorkerPool::getQueueStats (Lane lane)
+{
+  Histogram::Snapshot delays = getQueueDelays (lane);
+  QueueStats queueStats;
+
+  queueStats.tasks = delays.count;
+  queueStats.totalDelayUs = delays.sum;
+  queueStats.maxDelayUs = delays.max;
+
+  return queueStats;
+}
+
+Histogram::Snapshot
+WorkerPool::getQueueDelays (Lane lane)
+{
+  return laneDelays[static_cast<int> (lane)].getSnapshot ();
+}
+
+bool
+WorkerPool::isWorkerThread ()
+{
+  return currentPool != nullptr;
+}
+
+void
+WorkerPool::stop ()
+{
+  std::unique_lock<std::mutex> lock (mutex);
+
+  running = false;
+  cond.notify_all ();
+  lock.unlock ();
+
+  std::unique_lock<std::mutex> priorityLock (priorityMutex);
+  priorityCond.notify_all ();
+  priorityLock.unlock ();
+
+  if (priorityThread.joinable () ) {
+    if (priorityThread.get_id () != std::this_thread::get_id () ) {
+      priorityThread.join ();
+    } else {
+      priorityThread.detach ();
+    }
+  }
+
+  for (auto &worker : workers) {
+    if (worker->thread.joinable () ) {
+      if (worker->thread.get_id () != std::this_thread::get_id () ) {
+        worker->thread.join ();
+      } else {
+        worker->thread.detach ();
+      }
+    }
+  }
+}
+
+bool
+WorkerPool::pop (unsigned int index, std::function<void ()> &task)
+{
+  std::unique_lock<std::mutex> lock (workers[index]->mutex);
+
+  if (workers[index]->tasks.empty () ) {
+    return false;
+  }
+
+  task = std::move (workers[index]->tasks.front () );
+  workers[index]->tasks.pop_front ();
+
+  return true;
+}
+
+bool
+WorkerPool::steal (unsigned int index, std::function<void ()> &task)
+{
+  for (unsigned int i = 1; i < workers.size(); i++) {
+    Worker &victim = *workers[ (index + i) % workers.size()];
+    std::unique_lock<std::mutex> lock (victim.mutex, std::try_to_lock);
+
+    if (!lock.owns_lock () || victim.tasks.empty () ) {
+      continue;
+    }
+
+    task = std::move (victim.tasks.back () );
+    victim.tasks.pop_back ();
+
+    return true;
+  }
+
+  return false;
+}
+
+void
+WorkerPool::run (unsigned int index)
+{
+  currentPool = this;
+  currentIndex = index;
+
+  while (true) {
+    std::function<void ()> task;
+
+    if (popPriority (task) ) {
+      try {
+        task ();
+      } catch (std::exception &e) {
+        GST_ERROR ("Unexpected error while running task: %s", e.what() );
+      } catch (...) {
+        GST_ERROR ("Unexpected error while running task");
+      }
+
+      continue;
+    }
+
+    if (pop (index, task) || steal (index, task) ) {
+      pending--;
+
+      try {
+        task ();
+      } catch (std::exception &e) {
+        GST_ERROR ("Unexpected error while running task: %s", e.what() );
+      } catch (...) {
+        GST_ERROR ("Unexpected error while running task");
+      }
+
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock (mutex);
+
+    if (!running && pending == 0) {
+      break;
+    }
+
+    idle++;
+    /* Timed wait, just as a safety net against lost wake ups */
+    cond.wait_for (lock, std::chrono::milliseconds (100), [this] () {
+      return pending > 0 || !running;
+    });
+    idle--;
+  }
+
+  currentPool = nullptr;
+}
+
+/* Only runs priority tasks, so they never wait for a slow one */
+void
+WorkerPool::runPriority ()
+{
+  while (true) {
+    std::function<void ()> task;
+    std::unique_lock<std::mutex> lock (priorityMutex);
+
+    priorityCond.wait (lock, [this] () {
+      return !priorityTasks.empty () || !running;
+    });
+
+    if (priorityTasks.empty () ) {
+      break;
+    }
+
+    lock.unlock ();
+
+    if (!popPriority (task) ) {
+      /* Taken by a worker */
+      continue;
+    }
+
+    try {
+      task ();
+    } catch (std::exception &e) {
+      GST_ERROR ("Unexpected error while running task: %s", e.what() );
+    } catch (...) {
+      GST_ERROR ("Unexpected error while running task");
+    }
+  }
+}
+
+WorkerPool::StaticConstructor WorkerPool::staticConstructor;
+
+WorkerPool::StaticConstructor::StaticConstructor()
+{
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, GST_DEFAULT_NAME, 0,
+                           GST_DEFAULT_NAME);
+}
+
+} /* kurento */
@@ -0,0 +1,161 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __WORKER_POOL_HPP__
+#define __WORKER_POOL_HPP__
+
+#include <Executor.hpp>
+#include "Metrics.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace kurento
+{
+
+/**
+ * Fixed size pool of threads with one task queue per thread. Tasks posted
+ * from a worker go to its own queue, other tasks are distributed round robin.
+ * Idle workers steal tasks from the other queues before going to sleep.
+ *
+ * Keyed tasks are serialized on a strand per key, so tasks of one session run
+ * in order while different sessions run in parallel.
+ *
+ * Priority tasks have their own queue, checked by workers before their own
+ * ones, and a dedicated thread, so they run even when every worker is busy
+ * with a slow task.
+ */
+class WorkerPool : public Executor
+{
+public:
+  WorkerPool (unsigned int nThreads);
+  virtual ~WorkerPool() throw ();
+
+  virtual void post (std::function<void ()> task);
+  virtual void post (const std::string &key, std::function<void ()> task);
+  virtual void postAsync (const std::string &key,
+                          std::function<void (std::function<void ()> done) > task);
+  virtual void postPriority (std::function<void ()> task);
+  virtual void stop ();
+
+  enum class Lane {
+    NORMAL,
+    PRIORITY
+  };
+
+  /* Time spent by tasks waiting in a queue before starting */
+  struct QueueStats {
+    uint64_t tasks;
+    uint64_t totalDelayUs;
+    uint64_t maxDelayUs;
+  };
+
+  /**
+   * Queueing delay of the keyed tasks (normal lane) or of the priority ones
+   */
+  QueueStats getQueueStats (Lane lane);
+
+  /**
+   * Distribution of the queueing delays of a lane, in microseconds
+   */
+  Histogram::Snapshot getQueueDelays (Lane lane);
+
+  /**
+   * @returns true if the calling thread is a worker of any pool
+   */
+  static bool isWorkerThread ();
+
+  unsigned int getSize ()
+  {
+    return workers.size();
+  }
+
+private:
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct QueuedTask {
+    std::function<void ()> fn;
+    Clock::time_point queued;
+    /* Set instead of fn for strand tasks finishing asynchronously */
+    std::function<void (std::function<void ()>) > asyncFn;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void ()>> tasks;
+    std::thread thread;
+  };
+
+  struct Strand {
+    std::deque<QueuedTask> tasks;
+    bool scheduled = false;
+  };
+
+  struct StrandShard {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<Strand>> strands;
+  };
+
+  void run (unsigned int index);
+  void runPriority ();
+  bool popPriority (std::function<void ()> &task);
+  void recordDelay (Lane lane, Clock::time_point queued);
+  void postStrand (const std::string &key, QueuedTask task);
+  void runStrand (StrandShard &shard, const std::string &key,
+                  std::shared_ptr<Strand> strand);
+  bool pop (unsigned int index, std::function<void ()> &task);
+  bool steal (unsigned int index, std::function<void ()> &task);
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::unique_ptr<StrandShard>> strandShards;
+  std::atomic<unsigned int> next;
+  std::atomic<int> pending;
+  std::atomic<unsigned int> idle;
+  std::atomic<bool> running;
+
+  std::mutex mutex;
+  std::condition_variable cond;
+
+  std::deque<QueuedTask> priorityTasks;
+  std::atomic<unsigned int> priorityPending;
+  std::mutex priorityMutex;
+  std::condition_variable priorityCond;
+  std::thread priorityThread;
+
+  Histogram laneDelays[2];
+
+  class StaticConstructor
+  {
+  public:
+    StaticConstructor();
+  };
+
+  static StaticConstructor staticConstructor;
+};
+
+} /* kurento */
+
+#endif /* __WORKER_POOL_HPP__ */
@@ -19,6 +19,7 @@
 #include "death_handler.hpp"
 
 #include <glibmm.h>
+#include <glib-unix.h>
 #include <fstream>
 #include <iostream>
 #include "version.hpp"
@@ -58,9 +59,9 @@ namespace logging = boost::log;
 Glib::RefPtr<Glib::MainLoop> loop = Glib::MainLoop::create ();
 
 static std::shared_ptr<Transport>
-createTransportFromConfig (boost::property_tree::ptree &config)
+createTransportFromConfig (boost::property_tree::ptree &config,
+                           std::shared_ptr<ServerMethods> serverMethods)
 {
-  std::shared_ptr<ServerMethods> serverMethods (new ServerMethods (config) );
   std::shared_ptr<Transport> transport;
 
   try {
@@ -98,6 +99,17 @@ signal_handler (int signo)
   }
 }
 
+/* Runs on the main loop, not in the signal handler */
+static gboolean
+log_server_stats (gpointer data)
+{
+  ServerMethods *serverMethods = (ServerMethods *) data;
+
+  serverMethods->logServerStats ();
+
+  return G_SOURCE_CONTINUE;
+}
+
 static void
 kms_init_dependencies (int *argc, char ***argv)
 {
@@ -117,6 +129,7 @@ int
 main (int argc, char **argv)
 {
   struct sigaction signalAction;
+  std::shared_ptr<ServerMethods> serverMethods;
   std::shared_ptr<Transport> transport;
   boost::property_tree::ptree config;
   std::string confFile;
@@ -247,7 +260,11 @@ main (int argc, char **argv)
     killServerOnLowResources (*killResourceLimit);
   }
 
-  transport = createTransportFromConfig (config);
+  serverMethods = std::shared_ptr<ServerMethods> (new ServerMethods (config) );
+  transport = createTransportFromConfig (config, serverMethods);
+
+  /* Dump the request statistics to the log on SIGUSR1 */
+  g_unix_signal_add (SIGUSR1, log_server_stats, serverMethods.get () );
 
   /* Start transport */
   transport->start ();
@@ -0,0 +1,488 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "CborCodec.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#define MAJOR_UNSIGNED 0
+#define MAJOR_NEGATIVE 1
+#define MAJOR_BYTES 2
+#define MAJOR_TEXT 3
+#define MAJOR_ARRAY 4
+#define MAJOR_MAP 5
+#define MAJOR_TAG 6
+#define MAJOR_SIMPLE 7
+
+#define SIMPLE_FALSE 20
+#define SIMPLE_TRUE 21
+#define SIMPLE_NULL 22
+#define SIMPLE_UNDEFINED 23
+#define FLOAT_HALF 25
+#define FLOAT_SINGLE 26
+#define FLOAT_DOUBLE 27
+#define INDEFINITE 31
+#define BREAK 0xff
+
+/* Nesting allowed when decoding, as Json::Reader does */
+#define MAX_DEPTH 1000
+
+namespace kurento
+{
+
+const std::string &
+CborCodec::getName () const
+{
+  static const std::string name = "kurento-cbor";
+
+  return name;
+}
+
+static void
+appendHeader (std::string &out, int major, uint64_t value)
+{
+  char type = (char) (major << 5);
+
+  if (value < 24) {
+    out += (char) (type | value);
+  } else if (value <= 0xff) {
+    out += (char) (type | 24);
+    out += (char) value;
+  } else if (value <= 0xffff) {
+    out += (char) (type | 25);
+    out += (char) (value >> 8);
+    out += (char) value;
+  } else if (value <= 0xffffffff) {
+    out += (char) (type | 26);
+
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out += (char) (value >> shift);
+    }
+  } else {
+    out += (char) (type | 27);
+
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      out += (char) (value >> shift);
+    }
+  }
+}
+
+static void
+appendString (std::string &out, const char *str, size_t len)
+{
+  appendHeader (out, MAJOR_TEXT, len);
+  out.append (str, len);
+}
+
+static void
+appendReal (std::string &out, double value)
+{
+  float single = (float) value;
+  uint64_t bits;
+
+  if ( (double) single == value || std::isnan (value) ) {
+    uint32_t singleBits;
+
+    memcpy (&singleBits, &single, sizeof (singleBits) );
+    out += (char) ( (MAJOR_SIMPLE << 5) | FLOAT_SINGLE);
+
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out += (char) (singleBits >> shift);
+    }
+
+    return;
+  }
+
+  memcpy (&bits, &value, sizeof (bits) );
+  out += (char) ( (MAJOR_SIMPLE << 5) | FLOAT_DOUBLE);
+
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    out += (char) (bits >> shift);
+  }
+}
+
+static void
+appendValue (std::string &out, const Json::Value &value)
+{
+  switch (value.type () ) {
+  case Json::nullValue:
+    out += (char) ( (MAJOR_SIMPLE << 5) | SIMPLE_NULL);
+    break;
+
+  case Json::intValue: {
+    int64_t n = value.asLargestInt ();
+
+    if (n >= 0) {
+      appendHeader (out, MAJOR_UNSIGNED, n);
+    } else {
+      appendHeader (out, MAJOR_NEGATIVE, -1 - n);
+    }
+
+    break;
+  }
+
+  case Json::uintValue:
+    appendHeader (out, MAJOR_UNSIGNED, value.asLargestUInt () );
+    break;
+
+  case Json::realValue:
+    appendReal (out, value.asDouble () );
+    break;
+
+  case Json::stringValue: {
+    const char *begin;
+    const char *end;
+
+    value.getString (&begin, &end);
+    appendString (out, begin, end - begin);
+    break;
+  }
+
+  case Json::booleanValue:
+    out += (char) ( (MAJOR_SIMPLE << 5) | (value.asBool () ? SIMPLE_TRUE :
+                                           SIMPLE_FALSE) );
+    break;
+
+  case Json::arrayValue:
+    appendHeader (out, MAJOR_ARRAY, value.size () );
+
+    for (Json::ArrayIndex i = 0; i < value.size (); i++) {
+      appendValue (out, value[i]);
+    }
+
+    break;
+
+  case Json::objectValue:
+    appendHeader (out, MAJOR_MAP, value.size () );
+
+    for (auto it = value.begin (); it != value.end (); it++) {
+      const std::string &name = it.name ();
+
+      appendString (out, name.data (), name.size () );
+      appendValue (out, *it);
+    }
+
+    break;
+  }
+}
+
+void
+CborCodec::encode (const Json::Value &value, std::string &out) const
+{
+  out.clear ();
+  appendValue (out, value);
+}
+
+void
+CborCodec::encodeArray (const std::vector<std::string> &items,
+                        std::string &out) const
+{
+  out.clear ();
+  appendHeader (out, MAJOR_ARRAY, items.size () );
+
+  for (const std::string &item : items) {
+    out += item;
+  }
+}
+
+namespace
+{
+
+class Decoder
+{
+public:
+  Decoder (const std::string &message) :
+    p ( (const uint8_t *) message.data () ),
+    end ( (const uint8_t *) message.data () + message.size () ) {}
+
+  bool decode (Json::Value &value)
+  {
+    return readValue (value, 0) && p == end;
+  }
+
+private:
+  bool readBytes (size_t n, uint64_t &value)
+  {
+    if ( (size_t) (end - p) < n) {
+      return false;
+    }
+
+    value = 0;
+
+    for (size_t i = 0; i < n; i++) {
+      value = (value << 8) | *p++;
+    }
+
+    return true;
+  }
+
+  /* Reads the argument of an item, or sets indefinite for length 31 */
+  bool readArgument (uint8_t info, uint64_t &value, bool &indefinite)
+  {
+    indefinite = false;
+
+    if (info < 24) {
+      value = info;
+      return true;
+    }
+
+    switch (info) {
+    case 24:
+      return readBytes (1, value);
+
+    case 25:
+      return readBytes (2, value);
+
+    case 26:
+      return readBytes (4, value);
+
+    case 27:
+      return readBytes (8, value);
+
+    case INDEFINITE:
+      indefinite = true;
+      return true;
+
+    default:
+      return false;
+    }
+  }
+
+  bool isBreak ()
+  {
+    if (p < end && *p == BREAK) {
+      p++;
+      return true;
+    }
+
+    return false;
+  }
+
+  bool readText (uint64_t length, bool indefinite, std::string &text)
+  {
+    if (!indefinite) {
+      if ( (uint64_t) (end - p) < length) {
+        return false;
+      }
+
+      text.append ( (const char *) p, length);
+      p += length;
+      return true;
+    }
+
+    /* Chunks must be definite text strings */
+    while (!isBreak () ) {
+      uint64_t chunk;
+      bool chunkIndefinite;
+
+      if (p >= end || (*p >> 5) != MAJOR_TEXT
+          || !readArgument (*p++ & 0x1f, chunk, chunkIndefinite)
+          || chunkIndefinite || !readText (chunk, false, text) ) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  static double halfToDouble (uint16_t half)
+  {
+    int exponent = (half >> 10) & 0x1f;
+    int mantissa = half & 0x3ff;
+    double value;
+
+    if (exponent == 0) {
+      value = std::ldexp (mantissa, -24);
+    } else if (exponent != 31) {
+      value = std::ldexp (mantissa + 1024, exponent - 25);
+    } else {
+      value = mantissa == 0 ? INFINITY : NAN;
+    }
+
+    return (half & 0x8000) ? -value : value;
+  }
+
+  bool readSimple (uint8_t info, Json::Value &value)
+  {
+    uint64_t bits;
+
+    switch (info) {
+    case SIMPLE_FALSE:
+      value = false;
+      return true;
+
+    case SIMPLE_TRUE:
+      value = true;
+      return true;
+
+    case SIMPLE_NULL:
+    case SIMPLE_UNDEFINED:
+      value = Json::Value::null;
+      return true;
+
+    case FLOAT_HALF:
+      if (!readBytes (2, bits) ) {
+        return false;
+      }
+
+      value = halfToDouble ( (uint16_t) bits);
+      return true;
+
+    case FLOAT_SINGLE: {
+      uint32_t singleBits;
+      float single;
+
+      if (!readBytes (4, bits) ) {
+        return false;
+      }
+
+      singleBits = (uint32_t) bits;
+      memcpy (&single, &singleBits, sizeof (single) );
+      value = (double) single;
+      return true;
+    }
+
+    case FLOAT_DOUBLE: {
+      double real;
+
+      if (!readBytes (8, bits) ) {
+        return false;
+      }
+
+      memcpy (&real, &bits, sizeof (real) );
+      value = real;
+      return true;
+    }
+
+    default:
+      return false;
+    }
+  }
+
+  bool readValue (Json::Value &value, int depth)
+  {
+    uint8_t major, info;
+    uint64_t argument = 0;
+    bool indefinite;
+
+    if (p >= end || depth > MAX_DEPTH) {
+      return false;
+    }
+
+    major = *p >> 5;
+    info = *p & 0x1f;
+    p++;
+
+    if (major == MAJOR_SIMPLE) {
+      return readSimple (info, value);
+    }
+
+    if (!readArgument (info, argument, indefinite) ) {
+      return false;
+    }
+
+    switch (major) {
+    case MAJOR_UNSIGNED:
+      /* Small numbers are ints, as Json::Reader does */
+      if (argument <= (uint64_t) Json::Value::maxInt) {
+        value = Json::Value ( (Json::Int) argument);
+      } else if (argument <= (uint64_t) INT64_MAX) {
+        value = Json::Value ( (Json::Int64) argument);
+      } else {
+        value = Json::Value ( (Json::UInt64) argument);
+      }
+
+      return !indefinite;
+
+    case MAJOR_NEGATIVE:
+      if (indefinite || argument > (uint64_t) INT64_MAX) {
+        return false;
+      }
+
+      value = Json::Value ( (Json::Int64) (-1 - (int64_t) argument) );
+      return true;
+
+    case MAJOR_TEXT: {
+      std::string text;
+
+      if (!readText (argument, indefinite, text) ) {
+        return false;
+      }
+
+      value = text;
+      return true;
+    }
+
+    case MAJOR_ARRAY:
+      value = Json::Value (Json::arrayValue);
+
+      for (uint64_t i = 0; indefinite ? !isBreak () : i < argument; i++) {
+        Json::Value item;
+
+        if (!readValue (item, depth + 1) ) {
+          return false;
+        }
+
+        value.append (item);
+      }
+
+      return true;
+
+    case MAJOR_MAP:
+      value = Json::Value (Json::objectValue);
+
+      for (uint64_t i = 0; indefinite ? !isBreak () : i < argument; i++) {
+        Json::Value key;
+
+        /* JSON only has string keys */
+        if (!readValue (key, depth + 1) || !key.isString ()
+            || !readValue (value[key.asString ()], depth + 1) ) {
+          return false;
+        }
+      }
+
+      return true;
+
+    case MAJOR_TAG:
+      /* Tags only add semantics, the tagged item is kept as is */
+      return !indefinite && readValue (value, depth + 1);
+
+    default:
+      /* Byte strings */
+      return false;
+    }
+  }
+
+  const uint8_t *p;
+  const uint8_t *end;
+};
+
+} /* namespace */
+
+bool
+CborCodec::decode (const std::string &message, Json::Value &value) const
+{
+  Decoder decoder (message);
+
+  value = Json::Value::null;
+
+  return decoder.decode (value);
+}
+
+} /* kurento */
@@ -0,0 +1,57 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __CBOR_CODEC_HPP__
+#define __CBOR_CODEC_HPP__
+
+#include "Codec.hpp"
+
+namespace kurento
+{
+
+/**
+ * CBOR (RFC 7049) encoding of the JSON data model, selected with the
+ * "kurento-cbor" subprotocol.
+ *
+ * Numbers are encoded as integers when they are integers in the Json::Value,
+ * and reals as single precision floats when that does not lose precision.
+ * Decoding accepts definite and indefinite lengths, half precision floats
+ * and tags, which are ignored. Byte strings are not part of the JSON data
+ * model and are rejected.
+ */
+class CborCodec : public Codec
+{
+public:
+  CborCodec () {};
+  virtual ~CborCodec () {};
+
+  virtual const std::string &getName () const;
+
+  virtual bool isBinary () const
+  {
+    return true;
+  }
+
+  virtual bool decode (const std::string &message, Json::Value &value) const;
+  virtual void encode (const Json::Value &value, std::string &out) const;
+  virtual void encodeArray (const std::vector<std::string> &items,
+                            std::string &out) const;
+};
+
+} /* kurento */
+
+#endif /* __CBOR_CODEC_HPP__ */
@@ -0,0 +1,91 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "Codec.hpp"
+#include "CborCodec.hpp"
+#include "JsonBuffers.hpp"
+
+namespace kurento
+{
+
+class JsonCodec : public Codec
+{
+public:
+  virtual const std::string &getName () const
+  {
+    static const std::string name = "kurento-json";
+
+    return name;
+  }
+
+  virtual bool isBinary () const
+  {
+    return false;
+  }
+
+  virtual bool decode (const std::string &message, Json::Value &value) const
+  {
+    return parseJson (message, value);
+  }
+
+  virtual void encode (const Json::Value &value, std::string &out) const
+  {
+    writeJson (value, out);
+  }
+
+  virtual void encodeArray (const std::vector<std::string> &items,
+                            std::string &out) const
+  {
+    out = "[";
+
+    for (size_t i = 0; i < items.size(); i++) {
+      if (i > 0) {
+        out += ',';
+      }
+
+      out += items[i];
+    }
+
+    out += ']';
+  }
+};
+
+std::shared_ptr<Codec>
+Codec::getJsonCodec ()
+{
+  static std::shared_ptr<Codec> codec (new JsonCodec () );
+
+  return codec;
+}
+
+std::shared_ptr<Codec>
+Codec::getCodec (const std::string &name)
+{
+  static std::shared_ptr<Codec> cbor (new CborCodec () );
+
+  if (name.empty () || name == getJsonCodec ()->getName () ) {
+    return getJsonCodec ();
+  }
+
+  if (name == cbor->getName () ) {
+    return cbor;
+  }
+
+  return nullptr;
+}
+
+} /* kurento */
@@ -0,0 +1,83 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __CODEC_HPP__
+#define __CODEC_HPP__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+namespace kurento
+{
+
+/**
+ * Encoding of the JSON-RPC messages of a connection. Messages are always
+ * handled as Json::Value, codecs only change how they are sent.
+ *
+ * Codecs are stateless and shared by all the connections using them.
+ */
+class Codec
+{
+public:
+  Codec () {};
+  virtual ~Codec () {};
+
+  /**
+   * @returns The WebSocket subprotocol that selects this codec
+   */
+  virtual const std::string &getName () const = 0;
+
+  /**
+   * @returns true if messages have to be sent in binary frames
+   */
+  virtual bool isBinary () const = 0;
+
+  /**
+   * @returns false if the message is not valid in this encoding
+   */
+  virtual bool decode (const std::string &message, Json::Value &value) const = 0;
+
+  /**
+   * @param value The value to encode
+   * @param out The output, its previous contents are replaced
+   */
+  virtual void encode (const Json::Value &value, std::string &out) const = 0;
+
+  /**
+   * Build an array from already encoded items, as the response to a batch
+   */
+  virtual void encodeArray (const std::vector<std::string> &items,
+                            std::string &out) const = 0;
+
+  /**
+   * @param name A WebSocket subprotocol, or empty for the default encoding
+   * @returns The codec, or nullptr if there is none for the subprotocol
+   */
+  static std::shared_ptr<Codec> getCodec (const std::string &name);
+
+  /**
+   * @returns The text JSON codec, used when no subprotocol is selected
+   */
+  static std::shared_ptr<Codec> getJsonCodec ();
+};
+
+} /* kurento */
+
+#endif /* __CODEC_HPP__ */
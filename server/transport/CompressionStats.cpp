@@ -0,0 +1,51 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "CompressionStats.hpp"
+
+namespace kurento
+{
+
+std::atomic<uint64_t> CompressionStats::messages (0);
+std::atomic<uint64_t> CompressionStats::bytesIn (0);
+std::atomic<uint64_t> CompressionStats::bytesOut (0);
+std::atomic<uint64_t> CompressionStats::cpuTime (0);
+
+void
+CompressionStats::record (uint64_t in, uint64_t out, uint64_t time)
+{
+  messages.fetch_add (1, std::memory_order_relaxed);
+  bytesIn.fetch_add (in, std::memory_order_relaxed);
+  bytesOut.fetch_add (out, std::memory_order_relaxed);
+  cpuTime.fetch_add (time, std::memory_order_relaxed);
+}
+
+void
+CompressionStats::getStats (Json::Value &value)
+{
+  uint64_t in = bytesIn.load (std::memory_order_relaxed);
+  uint64_t out = bytesOut.load (std::memory_order_relaxed);
+
+  value["messages"] = Json::UInt64 (messages.load (std::memory_order_relaxed) );
+  value["bytesIn"] = Json::UInt64 (in);
+  value["bytesOut"] = Json::UInt64 (out);
+  /* Compressed size over original size, lower is better */
+  value["ratio"] = in > 0 ? (double) out / in : 1.0;
+  value["cpuMs"] = cpuTime.load (std::memory_order_relaxed) / 1e6;
+}
+
+} /* kurento */
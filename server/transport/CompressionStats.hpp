@@ -0,0 +1,58 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __COMPRESSION_STATS_HPP__
+#define __COMPRESSION_STATS_HPP__
+
+#include <json/json.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace kurento
+{
+
+/**
+ * Totals of the messages compressed by the transports since the server
+ * started
+ */
+class CompressionStats
+{
+public:
+  /**
+   * @param bytesIn Size of the message
+   * @param bytesOut Size once compressed
+   * @param cpuTime Nanoseconds of CPU time spent compressing
+   */
+  static void record (uint64_t bytesIn, uint64_t bytesOut, uint64_t cpuTime);
+
+  /**
+   * Fill value with the number of messages, bytes before and after
+   * compression, their ratio and the CPU time spent
+   */
+  static void getStats (Json::Value &value);
+
+private:
+  static std::atomic<uint64_t> messages;
+  static std::atomic<uint64_t> bytesIn;
+  static std::atomic<uint64_t> bytesOut;
+  static std::atomic<uint64_t> cpuTime;
+};
+
+} /* kurento */
+
+#endif /* __COMPRESSION_STATS_HPP__ */
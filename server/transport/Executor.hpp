@@ -0,0 +1,80 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __EXECUTOR_HPP__
+#define __EXECUTOR_HPP__
+
+#include <functional>
+#include <string>
+
+namespace kurento
+{
+
+class Executor
+{
+public:
+  Executor () {};
+  virtual ~Executor() throw () {};
+
+  /**
+   * Queue a task to be run asynchronously on one of the executor threads
+   *
+   * @param task The task to be run
+   */
+  virtual void post (std::function<void ()> task) = 0;
+
+  /**
+   * Queue a task to be run after all the tasks previously queued with the
+   * same key. Tasks queued with different keys may run in parallel.
+   *
+   * @param key The ordering key, usually the sessionId
+   * @param task The task to be run
+   */
+  virtual void post (const std::string &key, std::function<void ()> task) = 0;
+
+  /**
+   * Like the keyed post, for tasks that finish asynchronously. The task gets
+   * a function to call once it is done, from any thread. Later tasks of the
+   * same key do not start until it is called.
+   *
+   * @param key The ordering key, usually the sessionId
+   * @param task The task to be run
+   */
+  virtual void postAsync (const std::string &key,
+                          std::function<void (std::function<void ()> done) > task) = 0;
+
+  /**
+   * Queue a task ahead of the ones posted with the other methods, for cheap
+   * requests that should not wait behind slow ones. It is not ordered with
+   * keyed tasks. By default it is queued as a normal task.
+   *
+   * @param task The task to be run
+   */
+  virtual void postPriority (std::function<void ()> task)
+  {
+    post (task);
+  }
+
+  /**
+   * Stop accepting new tasks and wait for the queued ones to finish
+   */
+  virtual void stop () = 0;
+};
+
+} /* kurento */
+
+#endif /* __EXECUTOR_HPP__ */
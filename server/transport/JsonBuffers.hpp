@@ -0,0 +1,209 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __JSON_BUFFERS_HPP__
+#define __JSON_BUFFERS_HPP__
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <json/json.h>
+
+/* Buffers growing over this are released instead of kept for the next use */
+#define JSON_BUFFER_MAX_CAPACITY (64 * 1024)
+
+namespace kurento
+{
+
+/*
+ * Helpers to read and write JSON messages reusing per-thread state, instead
+ * of creating a Json::Reader or Json::FastWriter, and their internal
+ * buffers, for every message.
+ */
+
+/**
+ * Parse a message with the Json::Reader of the calling thread. The message is
+ * parsed in place, without the copy done by Json::Reader::parse(std::string)
+ *
+ * @returns false if the message is not valid JSON
+ */
+inline bool
+parseJson (const std::string &message, Json::Value &value)
+{
+  static thread_local Json::Reader reader;
+
+  return reader.parse (message.data (), message.data () + message.size (),
+                       value, false);
+}
+
+/* Strings can have \u0000 escapes, so they are not NUL terminated */
+inline void
+appendJsonString (std::string &out, const char *str, const char *end)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  out += '"';
+
+  for (const char *c = str; c < end; c++) {
+    switch (*c) {
+    case '"':
+      out += "\\\"";
+      break;
+
+    case '\\':
+      out += "\\\\";
+      break;
+
+    case '\b':
+      out += "\\b";
+      break;
+
+    case '\f':
+      out += "\\f";
+      break;
+
+    case '\n':
+      out += "\\n";
+      break;
+
+    case '\r':
+      out += "\\r";
+      break;
+
+    case '\t':
+      out += "\\t";
+      break;
+
+    default:
+      if ( (unsigned char) *c < 0x20) {
+        out += "\\u00";
+        out += hex[ (unsigned char) *c >> 4];
+        out += hex[ (unsigned char) *c & 0xf];
+      } else {
+        out += *c;
+      }
+    }
+  }
+
+  out += '"';
+}
+
+inline void
+appendJson (std::string &out, const Json::Value &value)
+{
+  char number[32];
+
+  switch (value.type () ) {
+  case Json::nullValue:
+    out += "null";
+    break;
+
+  case Json::intValue:
+    snprintf (number, sizeof (number), "%" PRId64,
+              (int64_t) value.asLargestInt () );
+    out += number;
+    break;
+
+  case Json::uintValue:
+    snprintf (number, sizeof (number), "%" PRIu64,
+              (uint64_t) value.asLargestUInt () );
+    out += number;
+    break;
+
+  case Json::realValue:
+    out += Json::valueToString (value.asDouble () );
+    break;
+
+  case Json::stringValue: {
+    const char *begin = "";
+    const char *end = begin;
+
+    value.getString (&begin, &end);
+    appendJsonString (out, begin, end);
+    break;
+  }
+
+  case Json::booleanValue:
+    out += value.asBool () ? "true" : "false";
+    break;
+
+  case Json::arrayValue:
+    out += '[';
+
+    for (Json::ArrayIndex i = 0; i < value.size (); i++) {
+      if (i > 0) {
+        out += ',';
+      }
+
+      appendJson (out, value[i]);
+    }
+
+    out += ']';
+    break;
+
+  case Json::objectValue:
+    out += '{';
+
+    for (auto it = value.begin (); it != value.end (); it++) {
+      if (it != value.begin () ) {
+        out += ',';
+      }
+
+      std::string name = it.name ();
+
+      appendJsonString (out, name.data (), name.data () + name.size () );
+      out += ':';
+      appendJson (out, *it);
+    }
+
+    out += '}';
+    break;
+  }
+}
+
+/**
+ * Write a value as compact JSON, reusing the memory already reserved by out
+ *
+ * @param value The value to write
+ * @param out The output, its previous contents are replaced
+ */
+inline void
+writeJson (const Json::Value &value, std::string &out)
+{
+  out.clear ();
+  appendJson (out, value);
+}
+
+/**
+ * Empty a buffer to be reused, releasing its memory if a large message made
+ * it grow too much.
+ */
+inline void
+recycleBuffer (std::string &buffer)
+{
+  if (buffer.capacity () > JSON_BUFFER_MAX_CAPACITY) {
+    std::string ().swap (buffer);
+  } else {
+    buffer.clear ();
+  }
+}
+
+} /* kurento */
+
+#endif /* __JSON_BUFFERS_HPP__ */
@@ -0,0 +1,118 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "ObjectAliases.hpp"
+
+namespace kurento
+{
+
+std::atomic<uint64_t> ObjectAliases::totalSavedBytes (0);
+
+ObjectAliases::ObjectAliases () : savedBytes (0), lastUse (Clock::now() )
+{
+}
+
+uint64_t
+ObjectAliases::getAlias (const std::string &objectId)
+{
+  std::unique_lock<std::mutex> lock (mutex);
+  auto it = aliases.find (objectId);
+
+  if (it != aliases.end () ) {
+    return it->second;
+  }
+
+  objectIds.push_back (objectId);
+  aliases[objectId] = objectIds.size ();
+
+  return objectIds.size ();
+}
+
+uint64_t
+ObjectAliases::findAlias (const std::string &objectId)
+{
+  std::unique_lock<std::mutex> lock (mutex);
+  auto it = aliases.find (objectId);
+
+  if (it == aliases.end () ) {
+    return 0;
+  }
+
+  return it->second;
+}
+
+bool
+ObjectAliases::getObjectId (uint64_t alias, std::string &objectId)
+{
+  std::unique_lock<std::mutex> lock (mutex);
+
+  if (alias == 0 || alias > objectIds.size () || objectIds[alias - 1].empty () ) {
+    return false;
+  }
+
+  objectId = objectIds[alias - 1];
+
+  return true;
+}
+
+void
+ObjectAliases::removeObject (const std::string &objectId)
+{
+  std::unique_lock<std::mutex> lock (mutex);
+  std::string prefix = objectId + "/";
+
+  for (auto it = aliases.begin (); it != aliases.end ();) {
+    if (it->first == objectId || it->first.compare (0, prefix.size (),
+        prefix) == 0) {
+      objectIds[it->second - 1].clear ();
+      it = aliases.erase (it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void
+ObjectAliases::addSavedBytes (uint64_t alias, const std::string &objectId)
+{
+  /* The id is sent as a quoted string, the alias as a bare number */
+  size_t idSize = objectId.size () + 2;
+  size_t aliasSize = std::to_string (alias).size ();
+
+  if (idSize > aliasSize) {
+    savedBytes += idSize - aliasSize;
+    totalSavedBytes += idSize - aliasSize;
+  }
+}
+
+void
+ObjectAliases::touch ()
+{
+  std::unique_lock<std::mutex> lock (mutex);
+
+  lastUse = Clock::now ();
+}
+
+ObjectAliases::Clock::time_point
+ObjectAliases::getLastUse ()
+{
+  std::unique_lock<std::mutex> lock (mutex);
+
+  return lastUse;
+}
+
+} /* kurento */
@@ -0,0 +1,101 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __OBJECT_ALIASES_HPP__
+#define __OBJECT_ALIASES_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kurento
+{
+
+/**
+ * Short integer aliases for the object ids used by one session, so clients
+ * can refer to objects without sending their full ids.
+ *
+ * Aliases start at 1 and are never reused by the session, an alias of a
+ * released object just stops resolving.
+ */
+class ObjectAliases
+{
+public:
+  ObjectAliases ();
+  ~ObjectAliases () {};
+
+  /**
+   * @returns The alias of the object, assigning a new one if it has none
+   */
+  uint64_t getAlias (const std::string &objectId);
+
+  /**
+   * @returns The alias of the object, or 0 if it has none
+   */
+  uint64_t findAlias (const std::string &objectId);
+
+  /**
+   * @returns false if the alias is unknown or its object was removed
+   */
+  bool getObjectId (uint64_t alias, std::string &objectId);
+
+  /**
+   * Forget the object and its children
+   */
+  void removeObject (const std::string &objectId);
+
+  /**
+   * Account the bytes saved by sending the alias instead of the object id
+   */
+  void addSavedBytes (uint64_t alias, const std::string &objectId);
+
+  uint64_t getSavedBytes ()
+  {
+    return savedBytes;
+  }
+
+  /**
+   * @returns The bytes saved by all the sessions since the server started
+   */
+  static uint64_t getTotalSavedBytes ()
+  {
+    return totalSavedBytes;
+  }
+
+  typedef std::chrono::steady_clock Clock;
+
+  void touch ();
+  Clock::time_point getLastUse ();
+
+private:
+  std::mutex mutex;
+  /* Object id of each alias, at alias - 1. Empty once removed. */
+  std::vector<std::string> objectIds;
+  std::unordered_map<std::string, uint64_t> aliases;
+  std::atomic<uint64_t> savedBytes;
+  Clock::time_point lastUse;
+
+  static std::atomic<uint64_t> totalSavedBytes;
+};
+
+} /* kurento */
+
+#endif /* __OBJECT_ALIASES_HPP__ */
@@ -19,6 +19,11 @@
 #define __PROCESSOR_HPP__
 
 #include <MediaObjectImpl.hpp>
+#include <jsonrpc/JsonRpcException.hpp>
+#include "Codec.hpp"
+#include "Executor.hpp"
+#include "JsonBuffers.hpp"
+#include "ObjectAliases.hpp"
 
 namespace kurento
 {
@@ -41,7 +46,113 @@ public:
   virtual std::string process (const std::string &request, std::string &response,
                                std::string &sessionId) = 0;
 
+  /**
+   * Called with the response to a request and the sessionId of the request.
+   * The response is only valid during the call.
+   */
+  typedef std::function<void (const std::string &response,
+                              const std::string &sessionId) > ResponseCallback;
+
+  /**
+   * Process the request without waiting for it to finish. The callback may
+   * be called before this returns or later from any thread. Transports do
+   * not start the next request of the session until it is called.
+   *
+   * The default implementation calls process and then the callback.
+   *
+   * @param request The request to be proccessed
+   * @param sessionId The sessionId associated with the channel that received
+   *                  the request
+   * @param callback Called once with the response
+   */
+  virtual void processAsync (const std::string &request,
+                             const std::string &sessionId, ResponseCallback callback)
+  {
+    std::string response;
+    std::string newSessionId = sessionId;
+
+    newSessionId = process (request, response, newSessionId);
+    callback (response, newSessionId);
+  }
+
+  /**
+   * Process a request encoded with codec, answering in the same encoding.
+   *
+   * The default implementation translates the request to JSON text for
+   * processAsync and its response back to codec.
+   */
+  virtual void processAsync (const std::string &request,
+                             const std::string &sessionId, std::shared_ptr<Codec> codec,
+                             ResponseCallback callback)
+  {
+    Json::Value value;
+    std::string jsonRequest;
+
+    if (codec == Codec::getJsonCodec () ) {
+      processAsync (request, sessionId, callback);
+      return;
+    }
+
+    if (!codec->decode (request, value) ) {
+      throw JsonRpc::CallException (JsonRpc::ErrorCode::PARSE_ERROR,
+                                    "Parse error.");
+    }
+
+    writeJson (value, jsonRequest);
+
+    processAsync (jsonRequest, sessionId, [codec, callback] (
+    const std::string & response, const std::string & newSessionId) {
+      Json::Value value;
+      std::string encoded;
+
+      if (!response.empty () && parseJson (response, value) ) {
+        codec->encode (value, encoded);
+      }
+
+      callback (encoded, newSessionId);
+    });
+  }
+
   virtual void keepAliveSession (const std::string &sessionId) = 0;
+
+  /**
+   * Whether the request is a cheap control request, like a ping, that should
+   * be processed ahead of the rest. It is not ordered with the other requests
+   * of its connection. Called on the transport network threads, so it must
+   * not parse the whole request.
+   */
+  virtual bool isPriorityRequest (const std::string &request)
+  {
+    return false;
+  }
+
+  /**
+   * Object aliases enabled by the session, used to translate the object ids
+   * of the events sent to it
+   *
+   * @returns The aliases, or nullptr if the session did not enable them
+   */
+  virtual std::shared_ptr<ObjectAliases> getObjectAliases (
+    const std::string &sessionId)
+  {
+    return nullptr;
+  }
+
+  /**
+   * Called by the transport when a client connects or disconnects, only
+   * used for statistics
+   */
+  virtual void connectionOpened () {}
+  virtual void connectionClosed () {}
+
+  /**
+   * Executor where requests should be processed
+   *
+   * @returns The executor, or nullptr if requests should be processed on the
+   *          transport threads
+   */
+  virtual std::shared_ptr<Executor> getExecutor () = 0;
+
   virtual void setEventSubscriptionHandler (std::function < std::string (
         std::shared_ptr<MediaObjectImpl> obj,
         const std::string &sessionId, const std::string &eventType,
@@ -0,0 +1,72 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "WriteStats.hpp"
+
+namespace kurento
+{
+
+static const char *BUCKET_NAMES[] = {"1", "2-3", "4-7", "8-15", "16+"};
+
+std::atomic<uint64_t> WriteStats::writes (0);
+std::atomic<uint64_t> WriteStats::frames (0);
+std::atomic<uint64_t> WriteStats::bytes (0);
+std::atomic<uint64_t> WriteStats::maxFrames (0);
+std::atomic<uint64_t> WriteStats::buckets[WriteStats::N_BUCKETS];
+
+void
+WriteStats::record (size_t n, size_t size)
+{
+  uint64_t max = maxFrames.load (std::memory_order_relaxed);
+  int bucket = 0;
+
+  while (bucket < N_BUCKETS - 1 && n >> (bucket + 1) != 0) {
+    bucket++;
+  }
+
+  writes.fetch_add (1, std::memory_order_relaxed);
+  frames.fetch_add (n, std::memory_order_relaxed);
+  bytes.fetch_add (size, std::memory_order_relaxed);
+  buckets[bucket].fetch_add (1, std::memory_order_relaxed);
+
+  while (n > max && !maxFrames.compare_exchange_weak (max, n,
+         std::memory_order_relaxed) ) {
+  }
+}
+
+void
+WriteStats::getStats (Json::Value &value)
+{
+  uint64_t w = writes.load (std::memory_order_relaxed);
+  uint64_t f = frames.load (std::memory_order_relaxed);
+
+  value["writes"] = Json::UInt64 (w);
+  value["frames"] = Json::UInt64 (f);
+  value["bytes"] = Json::UInt64 (bytes.load (std::memory_order_relaxed) );
+  value["framesPerWrite"] = w > 0 ? (double) f / w : 0.0;
+  value["maxFramesPerWrite"] = Json::UInt64 (maxFrames.load (
+                                 std::memory_order_relaxed) );
+  /* Each write is one writev, instead of one per frame */
+  value["savedWrites"] = Json::UInt64 (f - w);
+
+  for (int i = 0; i < N_BUCKETS; i++) {
+    value["framesPerWriteBuckets"][BUCKET_NAMES[i]] = Json::UInt64 (
+          buckets[i].load (std::memory_order_relaxed) );
+  }
+}
+
+} /* kurento */
@@ -0,0 +1,64 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __WRITE_STATS_HPP__
+#define __WRITE_STATS_HPP__
+
+#include <json/json.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace kurento
+{
+
+/**
+ * Totals of the writes done by the transports since the server started.
+ * Frames queued on a connection while its previous write is in progress, or
+ * before its write is run, are sent together in one write.
+ */
+class WriteStats
+{
+public:
+  /**
+   * @param frames Number of frames sent in the write
+   * @param bytes Size of the write
+   */
+  static void record (size_t frames, size_t bytes);
+
+  /**
+   * Fill value with the number of writes, frames and bytes, the average and
+   * maximum frames per write, how many frames per write were sent by how
+   * many writes and the writes saved by sending frames together
+   */
+  static void getStats (Json::Value &value);
+
+private:
+  /* Frames per write: 1, 2-3, 4-7, 8-15 and 16 or more */
+  static const int N_BUCKETS = 5;
+
+  static std::atomic<uint64_t> writes;
+  static std::atomic<uint64_t> frames;
+  static std::atomic<uint64_t> bytes;
+  static std::atomic<uint64_t> maxFrames;
+  static std::atomic<uint64_t> buckets[N_BUCKETS];
+};
+
+} /* kurento */
+
+#endif /* __WRITE_STATS_HPP__ */
@@ -0,0 +1,172 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "ConnectionRegistry.hpp"
+
+#include <algorithm>
+
+namespace kurento
+{
+
+ConnectionRegistry::Record::Record (const std::string &sessionId, Handle hdl,
+                                    bool secure) : sessionId (sessionId), hdl (hdl),
+  connection (hdl.lock ().get () ), secure (secure), messagesSent (0),
+  bytesSent (0), writes (0)
+{
+}
+
+std::shared_ptr<ConnectionRegistry::Record>
+ConnectionRegistry::find (const std::string &sessionId) const
+{
+  return sessions.find (sessionId);
+}
+
+std::shared_ptr<ConnectionRegistry::Record>
+ConnectionRegistry::find (Handle hdl) const
+{
+  std::shared_ptr<void> connection = hdl.lock ();
+
+  if (!connection) {
+    return nullptr;
+  }
+
+  return connections.find (connection.get () );
+}
+
+bool
+ConnectionRegistry::associate (const std::string &sessionId, Handle hdl,
+                               bool secure)
+{
+  std::shared_ptr<Record> record (new Record (sessionId, hdl, secure) );
+  std::shared_ptr<Record> bySession;
+  std::shared_ptr<Record> byConnection;
+  bool changed;
+
+  if (record->connection == nullptr) {
+    /* Already closed */
+    return false;
+  }
+
+  /* Usual case, each response of an associated session, without locking */
+  bySession = sessions.find (sessionId);
+
+  if (bySession && bySession->connection == record->connection
+      && bySession->secure == secure
+      && connections.find (record->connection) == bySession) {
+    return false;
+  }
+
+  Stripe &sessionStripe = getStripe (sessionId);
+  Stripe &connectionStripe = getStripe (record->connection);
+  std::unique_lock<std::mutex> sessionLock (sessionStripe.mutex,
+      std::defer_lock);
+  std::unique_lock<std::mutex> connectionLock (connectionStripe.mutex,
+      std::defer_lock);
+
+  if (&sessionStripe == &connectionStripe) {
+    sessionLock.lock ();
+  } else {
+    /* Without deadlocks with a change locking them the other way round */
+    std::lock (sessionLock, connectionLock);
+  }
+
+  auto it = connectionStripe.closed.find (record->connection);
+
+  if (it != connectionStripe.closed.end () ) {
+    if (!it->second.expired () ) {
+      /* Removed, but still alive, so this is the same connection */
+      return false;
+    }
+
+    connectionStripe.closed.erase (it);
+  }
+
+  bySession = sessions.find (sessionId);
+  byConnection = connections.find (record->connection);
+  changed = ! (bySession && bySession == byConnection);
+
+  if (!changed && bySession->secure == secure) {
+    return false;
+  }
+
+  if (bySession && bySession != byConnection) {
+    connections.erase (bySession->connection, bySession);
+  }
+
+  if (byConnection && byConnection->sessionId != sessionId) {
+    sessions.erase (byConnection->sessionId, byConnection);
+  }
+
+  sessions.put (sessionId, record);
+  connections.put (record->connection, record);
+
+  return changed;
+}
+
+std::shared_ptr<ConnectionRegistry::Record>
+ConnectionRegistry::remove (Handle hdl)
+{
+  std::shared_ptr<void> connection = hdl.lock ();
+  std::shared_ptr<Record> record;
+
+  if (!connection) {
+    return nullptr;
+  }
+
+  Stripe &stripe = getStripe<const void *> (connection.get () );
+  std::unique_lock<std::mutex> lock (stripe.mutex);
+
+  if (stripe.closed.size () >= stripe.closedSweepSize) {
+    for (auto it = stripe.closed.begin (); it != stripe.closed.end ();) {
+      if (it->second.expired () ) {
+        it = stripe.closed.erase (it);
+      } else {
+        ++it;
+      }
+    }
+
+    stripe.closedSweepSize = std::max<size_t> (CLOSED_SWEEP_SIZE,
+                             2 * stripe.closed.size () );
+  }
+
+  stripe.closed[connection.get ()] = hdl;
+  record = connections.find (connection.get () );
+
+  if (!record) {
+    return nullptr;
+  }
+
+  connections.erase (record->connection, record);
+  /* Without the lock of the session, only erased if it has this record */
+  sessions.erase (record->sessionId, record);
+
+  return record;
+}
+
+std::vector<std::string>
+ConnectionRegistry::getSessionIds () const
+{
+  std::vector<std::string> sessionIds;
+
+  sessions.forEach ([&sessionIds] (std::shared_ptr<Record> record) {
+    sessionIds.push_back (record->sessionId);
+  });
+
+  return sessionIds;
+}
+
+} /* kurento */
@@ -0,0 +1,221 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __CONNECTION_REGISTRY_HPP__
+#define __CONNECTION_REGISTRY_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kurento
+{
+
+#define CONNECTION_REGISTRY_SHARDS 64
+#define CLOSED_SWEEP_SIZE 1024
+
+/**
+ * Sessions associated with the WebSocket connections of the transport.
+ *
+ * Lookups, done for every event and response sent, only load the current
+ * version of a shard. Changes copy the shard and publish the new version.
+ * A change locks the stripes of the session and the connection it puts, and
+ * only erases the other entries while they have the replaced record, so the
+ * session and connection maps always agree once the changes are done.
+ */
+class ConnectionRegistry
+{
+public:
+  /* The same as websocketpp::connection_hdl */
+  typedef std::weak_ptr<void> Handle;
+
+  /**
+   * A connection with its session. Records are never modified, a new one
+   * replaces it when the association changes, except for the counters.
+   */
+  struct Record {
+    Record (const std::string &sessionId, Handle hdl, bool secure);
+
+    const std::string sessionId;
+    const Handle hdl;
+    /* Key of the connection, never dereferenced */
+    const void *const connection;
+    const bool secure;
+
+    std::atomic<uint64_t> messagesSent;
+    std::atomic<uint64_t> bytesSent;
+    /* Frames are written together, so usually fewer than messages */
+    std::atomic<uint64_t> writes;
+
+    void addSent (size_t bytes)
+    {
+      messagesSent.fetch_add (1, std::memory_order_relaxed);
+      bytesSent.fetch_add (bytes, std::memory_order_relaxed);
+    }
+
+    void addWrite ()
+    {
+      writes.fetch_add (1, std::memory_order_relaxed);
+    }
+  };
+
+  ConnectionRegistry () {};
+  ~ConnectionRegistry () {};
+
+  /**
+   * @returns The connection of the session, or nullptr
+   */
+  std::shared_ptr<Record> find (const std::string &sessionId) const;
+
+  /**
+   * @returns The record of the connection, or nullptr if it has no session
+   */
+  std::shared_ptr<Record> find (Handle hdl) const;
+
+  /**
+   * Associate the session with the connection, removing the previous
+   * associations of both. Nothing is done if the connection was removed,
+   * as responses can complete after their connection is closed.
+   *
+   * @returns true if the session was not already on this connection
+   */
+  bool associate (const std::string &sessionId, Handle hdl, bool secure);
+
+  /**
+   * Forget the connection and its session, it can not be associated again
+   *
+   * @returns The removed record, or nullptr if it had no session
+   */
+  std::shared_ptr<Record> remove (Handle hdl);
+
+  std::vector<std::string> getSessionIds () const;
+
+private:
+  template <typename Key>
+  class ShardedMap
+  {
+  public:
+    typedef std::unordered_map<Key, std::shared_ptr<Record>> Map;
+
+    ShardedMap ()
+    {
+      for (Shard &shard : shards) {
+        shard.map = std::shared_ptr<const Map> (new Map () );
+      }
+    }
+
+    std::shared_ptr<Record> find (const Key &key) const
+    {
+      std::shared_ptr<const Map> map = std::atomic_load (&getShard (key).map);
+      auto it = map->find (key);
+
+      if (it == map->end () ) {
+        return nullptr;
+      }
+
+      return it->second;
+    }
+
+    void put (const Key &key, std::shared_ptr<Record> record)
+    {
+      update (key, [&key, record] (Map & map) {
+        map[key] = record;
+        return true;
+      });
+    }
+
+    /* Only erases the key while it has this record */
+    void erase (const Key &key, std::shared_ptr<Record> record)
+    {
+      update (key, [&key, record] (Map & map) {
+        auto it = map.find (key);
+
+        if (it == map.end () || it->second != record) {
+          return false;
+        }
+
+        map.erase (it);
+        return true;
+      });
+    }
+
+    void forEach (std::function<void (std::shared_ptr<Record>) > f) const
+    {
+      for (const Shard &shard : shards) {
+        std::shared_ptr<const Map> map = std::atomic_load (&shard.map);
+
+        for (auto &entry : *map) {
+          f (entry.second);
+        }
+      }
+    }
+
+  private:
+    struct Shard {
+      std::mutex mutex;
+      std::shared_ptr<const Map> map;
+    };
+
+    Shard &getShard (const Key &key) const
+    {
+      return shards[std::hash<Key> () (key) % CONNECTION_REGISTRY_SHARDS];
+    }
+
+    void update (const Key &key, std::function<bool (Map &) > change)
+    {
+      Shard &shard = getShard (key);
+      std::unique_lock<std::mutex> lock (shard.mutex);
+      std::shared_ptr<Map> map (new Map (*shard.map) );
+
+      if (change (*map) ) {
+        std::atomic_store (&shard.map, std::shared_ptr<const Map> (map) );
+      }
+    }
+
+    mutable Shard shards[CONNECTION_REGISTRY_SHARDS];
+  };
+
+  ShardedMap<std::string> sessions;
+  ShardedMap<const void *> connections;
+
+  struct Stripe {
+    std::mutex mutex;
+    /*
+     * Removed connections still alive. Expired entries are only dropped when
+     * a new connection gets the same address or when too many accumulate.
+     */
+    std::unordered_map<const void *, Handle> closed;
+    size_t closedSweepSize = CLOSED_SWEEP_SIZE;
+  };
+
+  template <typename Key>
+  Stripe &getStripe (const Key &key)
+  {
+    return stripes[std::hash<Key> () (key) % CONNECTION_REGISTRY_SHARDS];
+  }
+
+  Stripe stripes[CONNECTION_REGISTRY_SHARDS];
+};
+
+} /* kurento */
+
+#endif /* __CONNECTION_REGISTRY_HPP__ */
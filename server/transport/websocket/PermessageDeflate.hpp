@@ -0,0 +1,112 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __PERMESSAGE_DEFLATE_HPP__
+#define __PERMESSAGE_DEFLATE_HPP__
+
+#include "CompressionStats.hpp"
+
+#include <websocketpp/config/core.hpp>
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+
+#include <ctime>
+
+namespace kurento
+{
+
+/**
+ * Compression settings of the WebSocket servers, read by each connection
+ * when it is created
+ */
+struct PermessageDeflateSettings {
+  bool enabled = false;
+  /* Base 2 logarithm of the compression window, from 9 to 15 */
+  uint8_t windowBits = 15;
+  /* Whether messages can refer to previous ones */
+  bool contextTakeover = true;
+  /* Smaller messages are sent uncompressed */
+  size_t minSize = 256;
+
+  static PermessageDeflateSettings &get ();
+};
+
+/**
+ * The websocketpp permessage-deflate extension, negotiated only when
+ * enabled in the settings and recording what it compresses
+ */
+template <typename config>
+class PermessageDeflate : public
+  websocketpp::extensions::permessage_deflate::enabled<config>
+{
+public:
+  typedef websocketpp::extensions::permessage_deflate::enabled<config> base;
+
+  PermessageDeflate () : implemented (PermessageDeflateSettings::get ().enabled)
+  {
+    const PermessageDeflateSettings &settings = PermessageDeflateSettings::get ();
+
+    if (!settings.contextTakeover) {
+      this->enable_server_no_context_takeover ();
+    }
+
+    /* Clients can ask for a smaller window, not for a larger one */
+    this->set_server_max_window_bits (settings.windowBits,
+                                      websocketpp::extensions::permessage_deflate::mode::largest);
+  }
+
+  bool is_implemented () const
+  {
+    return implemented;
+  }
+
+  websocketpp::lib::error_code compress (std::string const &in,
+                                         std::string &out)
+  {
+    struct timespec start, end;
+    size_t outSize = out.size ();
+    websocketpp::lib::error_code ec;
+
+    clock_gettime (CLOCK_THREAD_CPUTIME_ID, &start);
+    ec = base::compress (in, out);
+    clock_gettime (CLOCK_THREAD_CPUTIME_ID, &end);
+
+    CompressionStats::record (in.size (), out.size () - outSize,
+                              (end.tv_sec - start.tv_sec) * 1000000000LL +
+                              end.tv_nsec - start.tv_nsec);
+
+    return ec;
+  }
+
+private:
+  bool implemented;
+};
+
+/**
+ * A websocketpp server config using PermessageDeflate
+ */
+template <typename Base>
+struct PermessageDeflateConfig : public Base {
+  typedef PermessageDeflateConfig type;
+  typedef Base base;
+
+  typedef PermessageDeflate<typename Base::permessage_deflate_config>
+  permessage_deflate_type;
+};
+
+} /* kurento */
+
+#endif /* __PERMESSAGE_DEFLATE_HPP__ */
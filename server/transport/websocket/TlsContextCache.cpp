@@ -0,0 +1,157 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "TlsContextCache.hpp"
+#include <gst/gst.h>
+
+#include <stdexcept>
+
+#define GST_CAT_DEFAULT kurento_tls_context_cache
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+#define GST_DEFAULT_NAME "KurentoTlsContextCache"
+
+namespace kurento
+{
+
+/* Certificate changes are noticed after this, without a stat per handshake */
+static const std::chrono::seconds CERTIFICATE_CHECK_INTERVAL (5);
+
+static const unsigned char SESSION_ID_CONTEXT[] = "kurento";
+static const long SESSION_CACHE_SIZE = 20000;
+static const long SESSION_TIMEOUT = 300; /* 5 minutes */
+
+static boost::asio::ssl::context::options
+getVersionOptions (const std::string &minVersion)
+{
+  boost::asio::ssl::context::options options =
+    boost::asio::ssl::context::no_sslv2 | boost::asio::ssl::context::no_sslv3;
+
+  if (minVersion == "TLSv1") {
+    return options;
+  }
+
+  options |= boost::asio::ssl::context::no_tlsv1;
+
+  if (minVersion == "TLSv1.1") {
+    return options;
+  }
+
+  options |= boost::asio::ssl::context::no_tlsv1_1;
+
+  if (minVersion == "TLSv1.2") {
+    return options;
+  }
+
+  throw std::invalid_argument ("Unknown TLS version " + minVersion);
+}
+
+TlsContextCache::TlsContextCache (const boost::filesystem::path
+                                  &certificateFile, const std::string &password,
+                                  const std::string &minVersion) :
+  certificateFile (certificateFile), password (password)
+{
+  options = boost::asio::ssl::context::default_workarounds |
+            boost::asio::ssl::context::single_dh_use |
+            getVersionOptions (minVersion);
+
+  certificateTime = getCertificateTime ();
+  context = create ();
+  lastCheck = std::chrono::steady_clock::now ();
+
+  GST_INFO ("TLS context created, minimum version %s", minVersion.c_str () );
+}
+
+std::time_t
+TlsContextCache::getCertificateTime () const
+{
+  boost::system::error_code ec;
+  std::time_t time = boost::filesystem::last_write_time (certificateFile, ec);
+
+  return ec ? 0 : time;
+}
+
+TlsContextCache::ContextPtr
+TlsContextCache::create () const
+{
+  /* Negotiates the newest version both sides support */
+  ContextPtr newContext (new boost::asio::ssl::context (
+                           boost::asio::ssl::context::sslv23_server) );
+  std::string password = this->password;
+  SSL_CTX *ctx = newContext->native_handle ();
+
+  newContext->set_options (options);
+  newContext->set_password_callback (std::bind ([password] (void) ->
+  std::string {
+    return password;
+  }) );
+  newContext->use_certificate_chain_file (certificateFile.string () );
+  newContext->use_private_key_file (certificateFile.string (),
+                                    boost::asio::ssl::context::pem);
+
+  /* Resumption with session ids, kept in this context, and with tickets */
+  SSL_CTX_set_session_cache_mode (ctx, SSL_SESS_CACHE_SERVER);
+  SSL_CTX_set_session_id_context (ctx, SESSION_ID_CONTEXT,
+                                  sizeof (SESSION_ID_CONTEXT) - 1);
+  SSL_CTX_sess_set_cache_size (ctx, SESSION_CACHE_SIZE);
+  SSL_CTX_set_timeout (ctx, SESSION_TIMEOUT);
+  SSL_CTX_clear_options (ctx, SSL_OP_NO_TICKET);
+
+  return newContext;
+}
+
+TlsContextCache::ContextPtr
+TlsContextCache::get ()
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now ();
+  std::unique_lock<std::mutex> lock (mutex);
+  std::time_t time;
+
+  if (now - lastCheck < CERTIFICATE_CHECK_INTERVAL) {
+    return context;
+  }
+
+  lastCheck = now;
+  time = getCertificateTime ();
+
+  if (time == certificateTime) {
+    return context;
+  }
+
+  /* Do not try again with the same file if it fails */
+  certificateTime = time;
+
+  try {
+    context = create ();
+    GST_INFO ("Certificate %s changed, TLS context reloaded",
+              certificateFile.string ().c_str () );
+  } catch (std::exception &e) {
+    GST_ERROR ("Cannot reload certificate %s, keeping the previous one: %s",
+               certificateFile.string ().c_str (), e.what () );
+  }
+
+  return context;
+}
+
+TlsContextCache::StaticConstructor TlsContextCache::staticConstructor;
+
+TlsContextCache::StaticConstructor::StaticConstructor()
+{
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, GST_DEFAULT_NAME, 0,
+                           GST_DEFAULT_NAME);
+}
+
+} /* kurento */
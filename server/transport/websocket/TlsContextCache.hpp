@@ -0,0 +1,91 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __TLS_CONTEXT_CACHE_HPP__
+#define __TLS_CONTEXT_CACHE_HPP__
+
+#include <boost/asio/ssl/context.hpp>
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace kurento
+{
+
+/**
+ * TLS context shared by all the secure connections, so the certificate is
+ * only loaded again when its file changes. Sessions are cached and tickets
+ * enabled, so clients reconnecting can resume them instead of doing a full
+ * handshake.
+ */
+class TlsContextCache
+{
+public:
+  typedef std::shared_ptr<boost::asio::ssl::context> ContextPtr;
+
+  /**
+   * @param certificateFile PEM file with the certificate chain and the key
+   * @param minVersion Oldest protocol accepted: "TLSv1", "TLSv1.1" or
+   *                   "TLSv1.2"
+   *
+   * @throws std::exception if the version is unknown or the certificate can
+   *         not be loaded
+   */
+  TlsContextCache (const boost::filesystem::path &certificateFile,
+                   const std::string &password, const std::string &minVersion);
+  ~TlsContextCache () {};
+
+  /**
+   * @returns The current context, built again first if the certificate file
+   *          changed since it was loaded. A certificate that can not be
+   *          loaded is ignored until it changes again.
+   */
+  ContextPtr get ();
+
+  /**
+   * Build a context with the current certificate, not shared with anyone
+   */
+  ContextPtr create () const;
+
+private:
+  std::time_t getCertificateTime () const;
+
+  boost::filesystem::path certificateFile;
+  std::string password;
+  boost::asio::ssl::context::options options;
+
+  std::mutex mutex;
+  ContextPtr context;
+  std::time_t certificateTime;
+  std::chrono::steady_clock::time_point lastCheck;
+
+  class StaticConstructor
+  {
+  public:
+    StaticConstructor();
+  };
+
+  static StaticConstructor staticConstructor;
+};
+
+} /* kurento */
+
+#endif /* __TLS_CONTEXT_CACHE_HPP__ */
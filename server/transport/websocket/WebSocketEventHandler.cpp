@@ -30,20 +30,36 @@ namespace kurento
 
 WebSocketEventHandler::WebSocketEventHandler (std::shared_ptr <MediaObjectImpl>
     object, std::shared_ptr<WebSocketTransport> transport,
-    std::string sessionId) : EventHandler (object), transport (transport),
-  sessionId (sessionId)
+    std::string sessionId, std::shared_ptr<ObjectAliases> aliases) : EventHandler (
+        object), transport (transport), sessionId (sessionId), aliases (aliases)
 {
 
 }
 
+/* Replaces an object id by its alias, if the client already knows it */
+static void
+useAlias (ObjectAliases &aliases, Json::Value &value)
+{
+  uint64_t alias;
+
+  if (!value.isString () ) {
+    return;
+  }
+
+  alias = aliases.findAlias (value.asString () );
+
+  if (alias != 0) {
+    aliases.addSavedBytes (alias, value.asString () );
+    value = Json::Value::UInt64 (alias);
+  }
+}
+
 void
 WebSocketEventHandler::sendEvent (Json::Value &value)
 {
   try {
-    Json::StreamWriterBuilder strBuilder;
     Json::Value rpc;
     Json::Value event;
-    std::string eventStr;
 
     event ["value"] = value;
 
@@ -51,13 +67,21 @@ WebSocketEventHandler::sendEvent (Json::Value &value)
     rpc [JSON_RPC_METHOD] = "onEvent";
     rpc [JSON_RPC_PARAMS] = event;
 
-    strBuilder["indentation"] = "";
-    eventStr = Json::writeString (strBuilder, rpc);
-    GST_DEBUG ("Sending event: %s, sessionId: %s", eventStr.c_str(),
-               sessionId.c_str() );
+    if (aliases) {
+      Json::Value &eventValue = rpc [JSON_RPC_PARAMS]["value"];
+
+      if (eventValue.isMember ("object") ) {
+        useAlias (*aliases, eventValue["object"]);
+      }
+
+      if (eventValue.isMember ("data") && eventValue["data"].isObject ()
+          && eventValue["data"].isMember ("source") ) {
+        useAlias (*aliases, eventValue["data"]["source"]);
+      }
+    }
 
     try {
-      transport->send (sessionId, eventStr);
+      transport->send (sessionId, rpc);
     } catch (websocketpp::exception &e) {
       GST_ERROR ("Error on websocket while sending event to MediaHandler: %s",
                  e.code().message().c_str() );
@@ -27,7 +27,8 @@ class WebSocketEventHandler : public EventHandler
 {
 public:
   WebSocketEventHandler (std::shared_ptr <MediaObjectImpl> object,
-                         std::shared_ptr<WebSocketTransport> transport, std::string sessionId);
+                         std::shared_ptr<WebSocketTransport> transport, std::string sessionId,
+                         std::shared_ptr<ObjectAliases> aliases);
   virtual ~WebSocketEventHandler () {};
 
   virtual void sendEvent (Json::Value &value);
@@ -36,6 +37,7 @@ private:
 
   std::shared_ptr<WebSocketTransport> transport;
   std::string sessionId;
+  std::shared_ptr<ObjectAliases> aliases;
 
   class StaticConstructor
   {
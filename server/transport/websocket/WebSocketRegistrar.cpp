@@ -16,6 +16,7 @@
  */
 
 #include "WebSocketRegistrar.hpp"
+#include "JsonBuffers.hpp"
 #include <json/json.h>
 #include <gst/gst.h>
 
@@ -215,7 +216,6 @@ WebSocketRegistrar::connectionOpen (std::shared_ptr<ClientType> client,
 {
   Json::Value req;
   Json::Value params;
-  Json::FastWriter writer;
   std::string request;
 
   waitTime = DEFAULT_WAIT_TIME;
@@ -235,7 +235,7 @@ WebSocketRegistrar::connectionOpen (std::shared_ptr<ClientType> client,
 
   req["params"] = params;
 
-  request = writer.write (req);
+  writeJson (req, request);
   GST_DEBUG ("Registrar open, sending message: %s", request.c_str() );
 
   try {
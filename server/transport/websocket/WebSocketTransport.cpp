@@ -20,6 +20,9 @@
 #include "WebSocketTransport.hpp"
 #include "WebSocketEventHandler.hpp"
 #include "WebSocketRegistrar.hpp"
+#include "TlsContextCache.hpp"
+#include "JsonBuffers.hpp"
+#include "WriteStats.hpp"
 #include <jsonrpc/JsonRpcUtils.hpp>
 #include <jsonrpc/JsonRpcConstants.hpp>
 #include <KurentoException.hpp>
@@ -29,8 +32,12 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <type_traits>
 
+#include <pthread.h>
+#include <sys/socket.h>
+
 #define GST_CAT_DEFAULT kurento_websocket_transport
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 #define GST_DEFAULT_NAME "KurentoWebSocketTransport"
@@ -46,6 +53,9 @@ const std::string DEFAULT_LOCAL_ADDRESS = "localhost";
 const ushort WEBSOCKET_PORT_DEFAULT = 8888;
 const std::string WEBSOCKET_PATH_DEFAULT = "kurento";
 const int WEBSOCKET_THREADS_DEFAULT = 10;
+const std::string WEBSOCKET_TLS_MIN_VERSION_DEFAULT = "TLSv1";
+const uint WEBSOCKET_COMPRESSION_MIN_WINDOW_BITS = 9;
+const uint WEBSOCKET_COMPRESSION_MAX_WINDOW_BITS = 15;
 
 class configuration_exception : public std::exception
 {
@@ -64,10 +74,32 @@ private:
   std::string message;
 };
 
+#ifdef SO_REUSEPORT
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>
+reuse_port;
+
+/* Called before binding, so every listener can bind the same port */
+static websocketpp::lib::error_code
+setReusePort (std::shared_ptr<boost::asio::ip::tcp::acceptor> acceptor)
+{
+  boost::system::error_code ec;
+
+  acceptor->set_option (reuse_port (true), ec);
+
+  if (ec) {
+    GST_ERROR ("Cannot set SO_REUSEPORT: %s", ec.message().c_str() );
+    return websocketpp::transport::asio::error::make_error_code (
+             websocketpp::transport::asio::error::pass_through);
+  }
+
+  return websocketpp::lib::error_code ();
+}
+#endif
+
 WebSocketTransport::WebSocketTransport (const boost::property_tree::ptree
                                         &config,
                                         std::shared_ptr<Processor> processor) :
-  processor (processor)
+  processor (processor), executor (processor->getExecutor() )
 {
   ushort port;
   ushort securePort;
@@ -94,41 +126,73 @@ WebSocketTransport::WebSocketTransport (const boost::property_tree::ptree
     n_threads = WEBSOCKET_THREADS_DEFAULT;
   }
 
+  reusePort = config.get<bool> ("mediaServer.net.websocket.reusePort", false);
+
+  /* Read by each connection when it is created */
+  PermessageDeflateSettings &deflate = PermessageDeflateSettings::get ();
+
+  deflate.enabled =
+    config.get<bool> ("mediaServer.net.websocket.compression.enabled",
+                      deflate.enabled);
+  deflate.windowBits = std::min (WEBSOCKET_COMPRESSION_MAX_WINDOW_BITS,
+                                 std::max (WEBSOCKET_COMPRESSION_MIN_WINDOW_BITS,
+                                     config.get<uint> ("mediaServer.net.websocket.compression.windowBits",
+                                         deflate.windowBits) ) );
+  deflate.contextTakeover =
+    config.get<bool> ("mediaServer.net.websocket.compression.contextTakeover",
+                      deflate.contextTakeover);
+  deflate.minSize =
+    config.get<size_t> ("mediaServer.net.websocket.compression.minSize",
+                        deflate.minSize);
+
+  if (deflate.enabled) {
+    GST_INFO ("permessage-deflate enabled, window bits %d, context takeover %d, "
+              "min size %zu", deflate.windowBits, deflate.contextTakeover,
+              deflate.minSize);
+  }
+
+#ifndef SO_REUSEPORT
+
+  if (reusePort) {
+    GST_WARNING ("SO_REUSEPORT not supported, using one io_service for all the threads");
+    reusePort = false;
+  }
+
+#endif
+
   processor->setEventSubscriptionHandler (std::bind (
       &WebSocketTransport::processSubscription, this, std::placeholders::_1,
       std::placeholders::_2, std::placeholders::_3, std::placeholders::_4) );
 
+  /* Each listener accepts on its own socket, the kernel balances between them */
+  for (int i = 0; i < (reusePort ? n_threads : 1); i++) {
+    listeners.push_back (std::shared_ptr<Listener> (new Listener () ) );
+  }
+
+  GST_INFO ("Using %s", reusePort ?
+            "one io_service and SO_REUSEPORT acceptor per thread" :
+            "one io_service shared by all the threads");
+
   /* Configure server */
-  server.clear_access_channels (websocketpp::log::alevel::all);
-  server.clear_error_channels (websocketpp::log::alevel::all);
-
-  server.init_asio (&ios);
-  server.set_reuse_addr (true);
-  server.set_open_handler (std::bind ( (void (WebSocketTransport::*) (
-                                          WebSocketServer *, websocketpp::connection_hdl) )
-                                       &WebSocketTransport::openHandler, this,
-                                       &server, std::placeholders::_1) );
-  server.set_close_handler (std::bind (&WebSocketTransport::closeHandler, this,
-                                       std::placeholders::_1) );
-  server.set_message_handler (std::bind ( (void (WebSocketTransport::*) (
-      WebSocketServer *, websocketpp::connection_hdl,
-      WebSocketServer::message_ptr) ) &WebSocketTransport::processMessage,
-                                          this, &server, std::placeholders::_1,
-                                          std::placeholders::_2) );
+  for (std::shared_ptr<Listener> listener : listeners) {
+    initServer (listener->server, listener->ios);
 
-  try {
-    server.listen (port);
-  } catch (websocketpp::exception &e) {
-    GST_ERROR ("Error starting listen for websocket transport on port %d: %s", port,
-               e.what() );
-    exit (1);
+    try {
+      listener->server.listen (port);
+    } catch (websocketpp::exception &e) {
+      GST_ERROR ("Error starting listen for websocket transport on port %d: %s", port,
+                 e.what() );
+      exit (1);
+    }
   }
 
   /* Configure secure server if enabled */
   if (securePort != 0) {
     try {
       std::string password;
+      std::string minVersion;
       boost::filesystem::path certificateFile;
+      std::shared_ptr<TlsContextCache> tlsContexts;
 
       try {
         password =
@@ -154,54 +218,44 @@ WebSocketTransport::WebSocketTransport (const boost::property_tree::ptree
         throw configuration_exception ("Cannot get cerfificate file for secure websocket");
       }
 
-      secureServer.clear_access_channels (websocketpp::log::alevel::all);
-      secureServer.clear_error_channels (websocketpp::log::alevel::all);
-
-      secureServer.init_asio (&ios);
-      secureServer.set_reuse_addr (true);
-
-      secureServer.set_open_handler (std::bind ( (void (WebSocketTransport::*) (
-                                       SecureWebSocketServer *,
-                                       websocketpp::connection_hdl) ) &WebSocketTransport::openHandler, this,
-                                     &secureServer, std::placeholders::_1) );
-      secureServer.set_close_handler (std::bind (&WebSocketTransport::closeHandler,
-                                      this,
-                                      std::placeholders::_1) );
-      secureServer.set_message_handler (std::bind ( (void (WebSocketTransport::*) (
-                                          SecureWebSocketServer *, websocketpp::connection_hdl,
-                                          SecureWebSocketServer::message_ptr) ) &WebSocketTransport::processMessage,
-                                        this, &secureServer, std::placeholders::_1,
-                                        std::placeholders::_2) );
-
-      secureServer.set_tls_init_handler ( [password, certificateFile] (
-      websocketpp::connection_hdl hdl) -> context_ptr {
-        context_ptr context (new boost::asio::ssl::context (boost::asio::ssl::context::tlsv1) );
+      minVersion = config.get<std::string>
+                   ("mediaServer.net.websocket.secure.minVersion",
+                    WEBSOCKET_TLS_MIN_VERSION_DEFAULT);
+
+      try {
+        tlsContexts = std::shared_ptr<TlsContextCache> (new TlsContextCache (
+                        certificateFile, password, minVersion) );
+      } catch (std::exception &e) {
+        throw configuration_exception (std::string ("Error setting up tls: ") +
+                                       e.what() );
+      }
+
+      /* Connections share the context instead of loading the certificate */
+      auto tlsInitHandler = [tlsContexts] (websocketpp::connection_hdl hdl) ->
+      context_ptr {
+        return tlsContexts->get ();
+      };
+
+      for (std::shared_ptr<Listener> listener : listeners) {
+        initServer (listener->secureServer, listener->ios);
+        listener->secureServer.set_tls_init_handler (tlsInitHandler);
 
         try {
-          context->set_options (boost::asio::ssl::context::default_workarounds |
-          boost::asio::ssl::context::no_sslv2 |
-          boost::asio::ssl::context::single_dh_use);
-          context->set_password_callback (std::bind ([password] (void) -> std::string {
-            GST_INFO ("password");
-            return password;
-          }) );
-          context->use_certificate_chain_file (certificateFile.string() );
-          context->use_private_key_file (certificateFile.string(), boost::asio::ssl::context::pem);
-        } catch (std::exception &e)
-        {
-          GST_ERROR ("Error while setting up tls %s", e.what() );
-        }
+          listener->secureServer.listen (securePort);
+        } catch (websocketpp::exception &e) {
+          /* Do not leave sockets that would get connections nobody accepts */
+          for (std::shared_ptr<Listener> other : listeners) {
+            websocketpp::lib::error_code ec;
 
-        return context;
-      });
+            other->secureServer.stop_listening (ec);
+          }
 
-      try {
-        secureServer.listen (securePort);
-        hasSecureServer = true;
-      } catch (websocketpp::exception &e) {
-        throw configuration_exception ("Error listening on port" +
-                                       std::to_string (securePort) );
+          throw configuration_exception ("Error listening on port" +
+                                         std::to_string (securePort) );
+        }
       }
+
+      hasSecureServer = true;
     } catch (const configuration_exception &err) {
       GST_WARNING ("Secure websocket server not enabled: %s", err.what() );
     }
@@ -225,7 +279,45 @@ WebSocketTransport::~WebSocketTransport() throw ()
 {
 }
 
-void WebSocketTransport::run()
+template <typename ServerType>
+void
+WebSocketTransport::initServer (ServerType &s, boost::asio::io_service &ios)
+{
+  s.clear_access_channels (websocketpp::log::alevel::all);
+  s.clear_error_channels (websocketpp::log::alevel::all);
+
+  s.init_asio (&ios);
+  s.set_reuse_addr (true);
+
+#ifdef SO_REUSEPORT
+
+  if (reusePort) {
+    s.set_tcp_pre_bind_handler (&setReusePort);
+  }
+
+#endif
+
+  s.set_validate_handler (std::bind ( (bool (WebSocketTransport::*) (
+                                         ServerType *, websocketpp::connection_hdl) )
+                                      &WebSocketTransport::validateHandler, this,
+                                      &s, std::placeholders::_1) );
+  s.set_open_handler (std::bind ( (void (WebSocketTransport::*) (
+                                     ServerType *, websocketpp::connection_hdl) )
+                                  &WebSocketTransport::openHandler, this,
+                                  &s, std::placeholders::_1) );
+  s.set_close_handler (std::bind (&WebSocketTransport::closeHandler, this,
+                                  std::placeholders::_1) );
+  s.set_flush_handler (std::bind (&WebSocketTransport::flushHandler, this,
+                                  std::placeholders::_1, std::placeholders::_2,
+                                  std::placeholders::_3) );
+  s.set_message_handler (std::bind ( (void (WebSocketTransport::*) (
+                                        ServerType *, websocketpp::connection_hdl,
+                                        typename ServerType::message_ptr) ) &WebSocketTransport::processMessage,
+                                     this, &s, std::placeholders::_1,
+                                     std::placeholders::_2) );
+}
+
+void WebSocketTransport::run (boost::asio::io_service &ios)
 {
   bool running = true;
 
@@ -246,13 +338,10 @@ void WebSocketTransport::keepAliveSessions()
   std::unique_lock<std::recursive_mutex> lock (mutex);
 
   while (isRunning() ) {
-    std::list<std::string> conns;
-
-    for (auto c : connections) {
-      conns.push_back (c.first);
-    }
+    std::vector<std::string> conns;
 
     lock.unlock ();
+    conns = registry.getSessionIds ();
 
     for (auto c : conns) {
       GST_INFO ("Keep alive %s", c.c_str() );
@@ -276,14 +365,33 @@ void WebSocketTransport::keepAliveSessions()
 
 void WebSocketTransport::start ()
 {
-  server.start_accept();
+  for (std::shared_ptr<Listener> listener : listeners) {
+    listener->server.start_accept();
 
-  if (hasSecureServer) {
-    secureServer.start_accept();
+    if (hasSecureServer) {
+      listener->secureServer.start_accept();
+    }
   }
 
   for (int i = 0; i < n_threads; i++) {
-    threads.push_back (std::thread (std::bind (&WebSocketTransport::run, this) ) );
+    boost::asio::io_service &ios = listeners[i % listeners.size()]->ios;
+
+    threads.push_back (std::thread (std::bind (&WebSocketTransport::run, this,
+                                    std::ref (ios) ) ) );
+
+    if (reusePort) {
+      /* Keep the connections of each listener on the same core */
+      unsigned int cores = std::thread::hardware_concurrency();
+      cpu_set_t cpus;
+
+      CPU_ZERO (&cpus);
+      CPU_SET (i % std::max (cores, 1u), &cpus);
+
+      if (pthread_setaffinity_np (threads.back().native_handle(), sizeof (cpus),
+                                  &cpus) != 0) {
+        GST_WARNING ("Cannot pin websocket thread %d to a core", i);
+      }
+    }
   }
 
   std::unique_lock<std::recursive_mutex> lock (mutex);
@@ -304,12 +412,19 @@ void WebSocketTransport::stop ()
   lock.unlock();
 
   GST_DEBUG ("stop transport");
-  server.stop();
+
+  for (std::shared_ptr<Listener> listener : listeners) {
+    listener->server.stop();
+  }
 
   for (int i = 0; i < n_threads; i++) {
     threads[i].join();
   }
 
+  if (executor) {
+    executor->stop();
+  }
+
   if (registrar) {
     registrar->stop();
   }
@@ -317,121 +432,274 @@ void WebSocketTransport::stop ()
   keepAliveThread.join();
 }
 
-websocketpp::connection_hdl
-WebSocketTransport::getConnection (const std::string &sessionId)
+std::string
+WebSocketTransport::getSessionId (websocketpp::connection_hdl hdl)
 {
-  try {
-    std::unique_lock<std::recursive_mutex> lock (mutex);
-    return connections.at (sessionId);
-  } catch (std::out_of_range &e) {
-    throw std::out_of_range ("Connection not found for sessionId: " + sessionId);
+  std::shared_ptr<ConnectionRegistry::Record> record = registry.find (hdl);
+
+  if (!record) {
+    /* There is no previous sessionId */
+    return "";
   }
+
+  return record->sessionId;
 }
 
-void WebSocketTransport::storeConnection (const std::string &request,
-    const std::string &response, websocketpp::connection_hdl connection,
-    bool secure, std::string &sessionId)
+void WebSocketTransport::storeConnection (websocketpp::connection_hdl
+    connection, bool secure, std::string &sessionId)
 {
-  if (!sessionId.empty() ) {
-    std::unique_lock<std::recursive_mutex> lock (mutex);
-    bool needsWrite = false;
+  if (sessionId.empty() ) {
+    return;
+  }
 
-    try {
-      websocketpp::connection_hdl conn = connections.at (sessionId);
-
-      if (conn.lock() != connection.lock() ) {
-        GST_WARNING ("Erasing old connection associated with: %s",
-                     sessionId.c_str() );
-        connectionsReverse.erase (conn);
-        connections.erase (sessionId);
-        secureConnections.erase (sessionId);
-        needsWrite = true;
-      }
-    } catch (std::out_of_range &e) {
-      /* Ignore */
-      needsWrite = true;
-    }
+  if (registry.associate (sessionId, connection, secure) ) {
+    GST_DEBUG ("Asociating session %s", sessionId.c_str() );
 
     try {
-      std::string oldSession = connectionsReverse.at (connection);
-
-      if (oldSession != sessionId) {
-        GST_WARNING ("Erasing old sessionId %s associated with current connection",
-                     oldSession.c_str() );
-        connectionsReverse.erase (connection);
-        connections.erase (oldSession);
-        needsWrite = true;
+      processor->keepAliveSession (sessionId);
+    } catch (KurentoException &e) {
+      if (e.getCode () != INVALID_SESSION) {
+        throw e;
       }
-
-    } catch (std::out_of_range &e) {
-      needsWrite = true;
     }
-
-    if (needsWrite) {
-      GST_DEBUG ("Asociating session %s", sessionId.c_str() );
-      connections[sessionId] = connection;
-      connectionsReverse[connection] = sessionId;
-
-      try {
-        processor->keepAliveSession (sessionId);
-      } catch (KurentoException &e) {
-        if (e.getCode () != INVALID_SESSION) {
-          throw e;
-        }
-      }
-    }
-
-    secureConnections[sessionId] = secure;
   }
 }
 
 void
 WebSocketTransport::send (const std::string &sessionId,
-                          const std::string &message)
+                          const Json::Value &message)
 {
-  std::unique_lock <std::recursive_mutex> lock (mutex);
-  websocketpp::connection_hdl hdl = getConnection (sessionId);
+  /* Messages are sent synchronously, so the buffer can be reused right away */
+  static thread_local std::string messageStr;
+  std::shared_ptr<ConnectionRegistry::Record> record = registry.find (sessionId);
+  std::shared_ptr<Codec> codec;
+  /*
+   * Servers only get the connection from the handle, which sends on its own
+   * io_service, so any listener of the right type can be used
+   */
+  WebSocketServer &server = listeners.front()->server;
+  SecureWebSocketServer &secureServer = listeners.front()->secureServer;
+
+  if (!record) {
+    throw std::out_of_range ("Connection not found for sessionId: " + sessionId);
+  }
+
+  websocketpp::connection_hdl hdl = record->hdl;
 
   try {
-    if (secureConnections[sessionId]) {
-      lock.unlock();
-      secureServer.send (hdl, message, websocketpp::frame::opcode::TEXT);
+    if (record->secure) {
+      codec = getCodec (&secureServer, hdl);
     } else {
-      lock.unlock();
-      server.send (hdl, message, websocketpp::frame::opcode::TEXT);
+      codec = getCodec (&server, hdl);
     }
+
+    codec->encode (message, messageStr);
+
+    if (!codec->isBinary () ) {
+      GST_DEBUG ("Sending message: %s, sessionId: %s", messageStr.c_str(),
+                 sessionId.c_str() );
+    }
+
+    if (record->secure) {
+      sendMessage (&secureServer, hdl, messageStr, codec->isBinary () ?
+                   websocketpp::frame::opcode::BINARY : websocketpp::frame::opcode::TEXT);
+    } else {
+      sendMessage (&server, hdl, messageStr, codec->isBinary () ?
+                   websocketpp::frame::opcode::BINARY : websocketpp::frame::opcode::TEXT);
+    }
+
+    record->addSent (messageStr.size () );
   } catch (std::exception &e) {
     GST_ERROR ("Error sending event: %s", e.what() );
   }
+
+  recycleBuffer (messageStr);
+}
+
+template <typename ServerType>
+std::shared_ptr<Codec>
+WebSocketTransport::getCodec (ServerType *s, websocketpp::connection_hdl hdl)
+{
+  websocketpp::lib::error_code ec;
+  typename ServerType::connection_ptr connection = s->get_con_from_hdl (hdl,
+      ec);
+  std::shared_ptr<Codec> codec;
+
+  if (!ec) {
+    codec = Codec::getCodec (connection->get_subprotocol () );
+  }
+
+  if (!codec) {
+    codec = Codec::getJsonCodec ();
+  }
+
+  return codec;
+}
+
+/* The subprotocol can only be selected before the handshake response */
+template <typename ServerType>
+bool WebSocketTransport::validateHandler (ServerType *s,
+    websocketpp::connection_hdl hdl)
+{
+  typename ServerType::connection_ptr connection = s->get_con_from_hdl (hdl);
+
+  for (const std::string &subprotocol :
+       connection->get_requested_subprotocols () ) {
+    if (Codec::getCodec (subprotocol) ) {
+      GST_DEBUG ("Using subprotocol %s", subprotocol.c_str() );
+      connection->select_subprotocol (subprotocol);
+      break;
+    }
+  }
+
+  /* Clients not asking for a known subprotocol keep using JSON text */
+  return true;
 }
 
 template <typename ServerType>
 void WebSocketTransport::processMessage (ServerType *s,
     websocketpp::connection_hdl hdl, typename ServerType::message_ptr msg)
 {
-  std::string request = msg->get_payload();
-  std::string response;
-  std::string sessionId;
+  std::string strandKey;
 
-  try {
-    sessionId = connectionsReverse.at (hdl);
-  } catch (std::out_of_range &e) {
-    /* Ignore, there is no previous sessionId */
+  if (!executor) {
+    processRequest (s, hdl, msg->get_payload(), [] () {});
+    return;
   }
 
-  GST_DEBUG ("Message: %s", request.c_str() );
-  sessionId = processor->process (request, response, sessionId);
-  GST_DEBUG ("Response: %s", response.c_str() );
+  std::shared_ptr<WebSocketTransport> self = shared_from_this();
+
+  if (processor->isPriorityRequest (msg->get_payload() ) ) {
+    /*
+     * Control requests do not wait behind the queued ones of the connection,
+     * so they can be answered before requests received earlier
+     */
+    executor->postPriority ([self, s, hdl, msg] () {
+      self->processRequest (s, hdl, msg->get_payload(), [] () {});
+    });
+    return;
+  }
 
-  storeConnection (request, response, hdl,
-                   std::is_same<ServerType, SecureWebSocketServer>::value, sessionId);
+  /*
+   * Keep requests in the order they arrived on the connection. Not keyed by
+   * session, the requests received before the session was associated would
+   * be on another strand and could be overtaken.
+   */
+  strandKey = "connection:" + std::to_string (reinterpret_cast<uintptr_t>
+              (hdl.lock().get() ) );
+
+  /*
+   * Only decode on network threads, requests can take long to process. The
+   * next request waits until this one is answered, even if it finishes later.
+   */
+  executor->postAsync (strandKey, [self, s, hdl, msg] (
+  std::function<void () > done) {
+    self->processRequest (s, hdl, msg->get_payload(), done);
+  });
+}
 
-  try {
-    s->send (hdl, response, websocketpp::frame::opcode::TEXT);
-  } catch (websocketpp::exception &e) {
-    GST_ERROR ("Could not send response to client: %s",
-               e.code().message().c_str() );
+template <typename ServerType>
+void WebSocketTransport::processRequest (ServerType *s,
+    websocketpp::connection_hdl hdl, const std::string &request,
+    std::function<void () > done)
+{
+  std::shared_ptr<WebSocketTransport> self = shared_from_this();
+  bool secure = std::is_same<ServerType, SecureWebSocketServer>::value;
+  std::shared_ptr<Codec> codec = getCodec (s, hdl);
+  websocketpp::frame::opcode::value opcode = codec->isBinary () ?
+      websocketpp::frame::opcode::BINARY : websocketpp::frame::opcode::TEXT;
+
+  if (!codec->isBinary () ) {
+    GST_DEBUG ("Message: %s", request.c_str() );
+  }
+
+  /* Slow requests complete later, without keeping this thread */
+  processor->processAsync (request, getSessionId (hdl), codec, [self, s, hdl,
+  secure, codec, opcode, done] (const std::string & response,
+                                const std::string & newSessionId) {
+    std::string sessionId = newSessionId;
+
+    if (!codec->isBinary () ) {
+      GST_DEBUG ("Response: %s", response.c_str() );
+    }
+
+    try {
+      self->storeConnection (hdl, secure, sessionId);
+      self->sendResponse (s, hdl, response, opcode);
+    } catch (...) {
+      done ();
+      throw;
+    }
+
+    done ();
+  });
+}
+
+/* Like ServerType::send, but small messages are not compressed */
+template <typename ServerType>
+void WebSocketTransport::sendMessage (ServerType *s,
+                                      websocketpp::connection_hdl hdl, const std::string &message,
+                                      websocketpp::frame::opcode::value opcode)
+{
+  typename ServerType::connection_ptr connection = s->get_con_from_hdl (hdl);
+  typename ServerType::message_ptr msg = connection->get_message (opcode,
+                                         message.size () );
+  websocketpp::lib::error_code ec;
+
+  msg->append_payload (message);
+  msg->set_compressed (message.size () >= PermessageDeflateSettings::get ().minSize);
+
+  ec = connection->send (msg);
+
+  if (ec) {
+    throw websocketpp::exception (ec);
+  }
+}
+
+template <typename ServerType>
+void WebSocketTransport::sendResponse (ServerType *s,
+                                       websocketpp::connection_hdl hdl, const std::string &response,
+                                       websocketpp::frame::opcode::value opcode)
+{
+  websocketpp::lib::error_code ec;
+  typename ServerType::connection_ptr connection = s->get_con_from_hdl (hdl,
+      ec);
+  std::shared_ptr<ConnectionRegistry::Record> record;
+
+  if (ec) {
+    GST_WARNING ("Connection closed before sending the response: %s",
+                 ec.message().c_str() );
+    return;
+  }
+
+  record = registry.find (hdl);
+
+  if (record) {
+    record->addSent (response.size () );
+  }
+
+  if (!executor) {
+    try {
+      sendMessage (s, hdl, response, opcode);
+    } catch (websocketpp::exception &e) {
+      GST_ERROR ("Could not send response to client: %s",
+                 e.code().message().c_str() );
+    }
+
+    return;
   }
+
+  /* Hand the response back to the network thread owning the connection */
+  std::shared_ptr<WebSocketTransport> self = shared_from_this();
+
+  connection->get_strand()->post ([self, s, hdl, response, opcode] () {
+    try {
+      self->sendMessage (s, hdl, response, opcode);
+    } catch (websocketpp::exception &e) {
+      GST_ERROR ("Could not send response to client: %s",
+                 e.code().message().c_str() );
+    }
+  });
 }
 
 template <typename ServerType>
@@ -442,6 +710,7 @@ void WebSocketTransport::openHandler (ServerType *s,
   std::string resource = connection->get_resource();
 
   GST_DEBUG ("Client connected from %s", connection->get_origin().c_str() );
+  processor->connectionOpened ();
 
   if (resource.size() >= 1 && resource[0] == '/') {
     resource = resource.substr (1);
@@ -469,7 +738,7 @@ WebSocketTransport::processSubscription (std::shared_ptr< MediaObjectImpl > obj,
   std::string subscriptionId;
   std::string eventId = sessionId + "|" + obj->getId() + "|" + eventType;
   std::shared_ptr <EventHandler> handler;
-  std::unique_lock<std::recursive_mutex> lock (mutex);
+  std::unique_lock<std::mutex> lock (handlersMutex);
 
   if (handlers.find (eventId) != handlers.end() ) {
     handler = handlers[eventId].lock();
@@ -477,7 +746,7 @@ WebSocketTransport::processSubscription (std::shared_ptr< MediaObjectImpl > obj,
 
   if (!handler) {
     handler = std::shared_ptr <EventHandler> (new WebSocketEventHandler (obj,
-              shared_from_this(), sessionId) );
+              shared_from_this(), sessionId, processor->getObjectAliases (sessionId) ) );
 
     subscriptionId = processor->connectEventHandler (obj, sessionId, eventType,
                      handler);
@@ -492,18 +761,36 @@ WebSocketTransport::processSubscription (std::shared_ptr< MediaObjectImpl > obj,
 
 void WebSocketTransport::closeHandler (websocketpp::connection_hdl hdl)
 {
+  std::shared_ptr<ConnectionRegistry::Record> record;
+
   GST_DEBUG ("Connection closed");
+  processor->connectionClosed ();
 
-  try {
-    std::unique_lock<std::recursive_mutex> lock (mutex);
-    std::string sessionId = connectionsReverse.at (hdl);
-
-    GST_DEBUG ("Erasing connection associated with: %s", sessionId.c_str() );
-    connections.erase (sessionId);
-    connectionsReverse.erase (hdl);
-    secureConnections.erase (sessionId);
-  } catch (std::out_of_range &e) {
-    /* Ignore */
+  record = registry.remove (hdl);
+
+  if (record) {
+    GST_DEBUG ("Erased connection associated with: %s, %" G_GUINT64_FORMAT
+               " messages and %" G_GUINT64_FORMAT " bytes sent in %"
+               G_GUINT64_FORMAT " writes", record->sessionId.c_str(),
+               record->messagesSent.load (), record->bytesSent.load (),
+               record->writes.load () );
+  }
+}
+
+/*
+ * Called on the network thread each time the frames queued on a connection
+ * are written, responses and events queued meanwhile from other threads go
+ * together in one write
+ */
+void WebSocketTransport::flushHandler (websocketpp::connection_hdl hdl,
+                                       size_t frames, size_t bytes)
+{
+  std::shared_ptr<ConnectionRegistry::Record> record = registry.find (hdl);
+
+  WriteStats::record (frames, bytes);
+
+  if (record) {
+    record->addWrite ();
   }
 }
 
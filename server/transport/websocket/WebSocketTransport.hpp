@@ -20,6 +20,8 @@
 
 #include "Transport.hpp"
 #include "Processor.hpp"
+#include "Codec.hpp"
+#include "ConnectionRegistry.hpp"
 
 #ifndef _WEBSOCKETPP_CPP11_STL_
 #define _WEBSOCKETPP_CPP11_STL_
@@ -27,13 +29,16 @@
 
 #include <websocketpp/config/asio.hpp>
 #include <websocketpp/server.hpp>
+#include "PermessageDeflate.hpp"
 #include <iostream>
 #include <thread>
 #include <condition_variable>
 
-typedef websocketpp::server<websocketpp::config::asio> WebSocketServer;
-typedef websocketpp::server<websocketpp::config::asio_tls>
-SecureWebSocketServer;
+typedef websocketpp::server<kurento::PermessageDeflateConfig<websocketpp::config::asio>>
+    WebSocketServer;
+typedef
+websocketpp::server<kurento::PermessageDeflateConfig<websocketpp::config::asio_tls>>
+    SecureWebSocketServer;
 
 namespace kurento
 {
@@ -50,26 +55,57 @@ public:
   virtual void start ();
   virtual void stop ();
 
-  void send (const std::string &sessionId, const std::string &message);
+  /**
+   * Send a message to the session, encoded as negotiated by its connection
+   */
+  void send (const std::string &sessionId, const Json::Value &message);
 
 private:
 
-  websocketpp::connection_hdl getConnection (const std::string &sessionId);
+  /*
+   * An io_service with the servers using it. There is one shared by all the
+   * threads, or one per thread when reusing the port.
+   */
+  struct Listener {
+    boost::asio::io_service ios;
+    WebSocketServer server;
+    SecureWebSocketServer secureServer;
+  };
+
+  std::string getSessionId (websocketpp::connection_hdl hdl);
 
+  template <typename ServerType>
+  void initServer (ServerType &s, boost::asio::io_service &ios);
+  template <typename ServerType>
+  std::shared_ptr<Codec> getCodec (ServerType *s,
+                                   websocketpp::connection_hdl hdl);
+  template <typename ServerType>
+  bool validateHandler (ServerType *s, websocketpp::connection_hdl hdl);
   template <typename ServerType>
   void processMessage (ServerType *s, websocketpp::connection_hdl hdl,
                        typename ServerType::message_ptr msg);
   template <typename ServerType>
+  void processRequest (ServerType *s, websocketpp::connection_hdl hdl,
+                       const std::string &request, std::function<void () > done);
+  template <typename ServerType>
+  void sendMessage (ServerType *s, websocketpp::connection_hdl hdl,
+                    const std::string &message, websocketpp::frame::opcode::value opcode);
+  template <typename ServerType>
+  void sendResponse (ServerType *s, websocketpp::connection_hdl hdl,
+                     const std::string &response, websocketpp::frame::opcode::value opcode);
+  template <typename ServerType>
   void openHandler (ServerType *s, websocketpp::connection_hdl hdl);
   void closeHandler (websocketpp::connection_hdl hdl);
-  void run ();
+  void flushHandler (websocketpp::connection_hdl hdl, size_t frames,
+                     size_t bytes);
+  void run (boost::asio::io_service &ios);
 
   virtual std::string processSubscription (std::shared_ptr<MediaObjectImpl> obj,
       const std::string &sessionId, const std::string &eventType,
       const Json::Value &params);
 
-  void storeConnection (const std::string &request, const std::string &response,
-                        websocketpp::connection_hdl connection, bool secure, std::string &sessionId);
+  void storeConnection (websocketpp::connection_hdl connection, bool secure,
+                        std::string &sessionId);
 
   void keepAliveSessions ();
 
@@ -79,18 +115,16 @@ private:
   }
 
   std::shared_ptr<Processor> processor;
+  std::shared_ptr<Executor> executor;
 
-  std::map <std::string, websocketpp::connection_hdl> connections;
-  std::map <std::string, bool> secureConnections;
-  std::map <websocketpp::connection_hdl, std::string,
-      std::owner_less<websocketpp::connection_hdl>> connectionsReverse;
+  ConnectionRegistry registry;
+  /* Guards the running state */
   std::recursive_mutex mutex;
 
   int n_threads;
   std::string path;
-  boost::asio::io_service ios;
-  WebSocketServer server;
-  SecureWebSocketServer secureServer;
+  bool reusePort = false;
+  std::vector<std::shared_ptr<Listener>> listeners;
   bool hasSecureServer = false;
   std::vector<std::thread> threads;
   std::thread keepAliveThread;
@@ -98,6 +132,8 @@ private:
   std::condition_variable_any cond;
   std::shared_ptr <WebSocketRegistrar> registrar;
 
+  /* Own lock, so subscriptions do not wait for start and stop */
+  std::mutex handlersMutex;
   std::map <std::string, std::weak_ptr<kurento::EventHandler>> handlers;
 
   class StaticConstructor
@@ -151,6 +151,15 @@ typedef lib::function<bool (connection_hdl) > validate_handler;
  */
 typedef lib::function<void (connection_hdl) > http_handler;
 
+/// The type and function signature of a flush handler
+/**
+ * The flush handler is called each time queued frames are handed to the
+ * transport in one write, with the number of frames and bytes written. It
+ * can be used to measure how many frames are coalesced per write.
+ */
+typedef lib::function<void (connection_hdl, size_t frames, size_t bytes) >
+flush_handler;
+
 //
 typedef lib::function<void (lib::error_code const &ec, size_t bytes_transferred) >
 read_handler;
@@ -326,6 +335,7 @@ public:
     , m_msg_manager (new con_msg_manager_type() )
     , m_send_buffer_size (0)
     , m_write_flag (false)
+    , m_write_scheduled (false)
     , m_read_flag (true)
     , m_is_server (p_is_server)
     , m_alog (alog)
@@ -493,6 +503,17 @@ public:
     m_message_handler = h;
   }
 
+  /// Set flush handler
+  /**
+   * The flush handler is called when queued frames are written.
+   *
+   * @param h The new flush_handler
+   */
+  void set_flush_handler (flush_handler h)
+  {
+    m_flush_handler = h;
+  }
+
   //////////////////////////////////////////
   // Connection timeouts and other limits //
   //////////////////////////////////////////
@@ -1375,6 +1396,12 @@ public:
    * non-zero otherwise.
    */
   void handle_write_frame (lib::error_code const &ec);
+
+  /// Checks if a write_frame needs to be dispatched and marks it as scheduled
+  /**
+   * Lock m_write_lock
+   */
+  bool schedule_write();
 // protected:
   // This set of methods would really like to be protected, but doing so
   // requires that the endpoint be able to friend the connection. This is
@@ -1552,6 +1579,7 @@ private:
   http_handler            m_http_handler;
   validate_handler        m_validate_handler;
   message_handler         m_message_handler;
+  flush_handler           m_flush_handler;
 
   /// constant values
   long                    m_open_handshake_timeout_dur;
@@ -1631,6 +1659,12 @@ private:
    */
   bool m_write_flag;
 
+  /// True if a write_frame has been dispatched and has not run yet
+  /**
+   * Lock m_write_lock
+   */
+  bool m_write_scheduled;
+
   /// True if this connection is presently reading new data
   bool m_read_flag;
 
@@ -140,6 +140,7 @@ public:
     , m_http_handler (std::move (o.m_http_handler) )
     , m_validate_handler (std::move (o.m_validate_handler) )
     , m_message_handler (std::move (o.m_message_handler) )
+    , m_flush_handler (std::move (o.m_flush_handler) )
 
     , m_open_handshake_timeout_dur (o.m_open_handshake_timeout_dur)
     , m_close_handshake_timeout_dur (o.m_close_handshake_timeout_dur)
@@ -345,6 +346,12 @@ public:
     scoped_lock_type guard (m_mutex);
     m_message_handler = h;
   }
+  void set_flush_handler (flush_handler h)
+  {
+    m_alog.write (log::alevel::devel, "set_flush_handler");
+    scoped_lock_type guard (m_mutex);
+    m_flush_handler = h;
+  }
 
   //////////////////////////////////////////
   // Connection timeouts and other limits //
@@ -711,6 +718,7 @@ private:
   http_handler                m_http_handler;
   validate_handler            m_validate_handler;
   message_handler             m_message_handler;
+  flush_handler               m_flush_handler;
 
   long                        m_open_handshake_timeout_dur;
   long                        m_close_handshake_timeout_dur;
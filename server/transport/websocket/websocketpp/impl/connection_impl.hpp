@@ -128,7 +128,7 @@ lib::error_code connection<config>::send (typename config::message_type::ptr
 
     scoped_lock_type lock (m_write_lock);
     write_push (outgoing_msg);
-    needs_writing = !m_write_flag && !m_send_queue.empty();
+    needs_writing = schedule_write();
   } else {
     outgoing_msg = m_msg_manager->get_message();
 
@@ -144,7 +144,7 @@ lib::error_code connection<config>::send (typename config::message_type::ptr
     }
 
     write_push (outgoing_msg);
-    needs_writing = !m_write_flag && !m_send_queue.empty();
+    needs_writing = schedule_write();
   }
 
   if (needs_writing) {
@@ -219,7 +219,7 @@ void connection<config>::ping (std::string const &payload, lib::error_code &ec)
   {
     scoped_lock_type lock (m_write_lock);
     write_push (msg);
-    needs_writing = !m_write_flag && !m_send_queue.empty();
+    needs_writing = schedule_write();
   }
 
   if (needs_writing) {
@@ -298,7 +298,7 @@ void connection<config>::pong (std::string const &payload, lib::error_code &ec)
   {
     scoped_lock_type lock (m_write_lock);
     write_push (msg);
-    needs_writing = !m_write_flag && !m_send_queue.empty();
+    needs_writing = schedule_write();
   }
 
   if (needs_writing) {
@@ -1876,6 +1876,9 @@ void connection<config>::write_frame()
   {
     scoped_lock_type lock (m_write_lock);
 
+    // Messages queued from now on need another write_frame
+    m_write_scheduled = false;
+
     // Check the write flag. If true, there is an outstanding transport
     // write already. In this case we just return. The write handler will
     // start a new write if the write queue isn't empty. If false, we set
@@ -1910,6 +1913,7 @@ void connection<config>::write_frame()
   }
 
   typename std::vector<message_ptr>::iterator it;
+  size_t bytes = 0;
 
   for (it = m_current_msgs.begin(); it != m_current_msgs.end(); ++it) {
     std::string const &header = (*it)->get_header();
@@ -1917,6 +1921,11 @@ void connection<config>::write_frame()
 
     m_send_buffer.push_back (transport::buffer (header.c_str(), header.size() ) );
     m_send_buffer.push_back (transport::buffer (payload.c_str(), payload.size() ) );
+    bytes += header.size() + payload.size();
+  }
+
+  if (m_flush_handler) {
+    m_flush_handler (m_connection_hdl, m_current_msgs.size(), bytes);
   }
 
   // Print detailed send stats if those log levels are enabled
@@ -1969,6 +1978,19 @@ void connection<config>::write_frame()
   );
 }
 
+template <typename config>
+bool connection<config>::schedule_write()
+{
+  // Only one write_frame is dispatched at a time, it sends everything
+  // queued until it runs in a single transport write
+  if (m_write_flag || m_write_scheduled || m_send_queue.empty() ) {
+    return false;
+  }
+
+  m_write_scheduled = true;
+  return true;
+}
+
 template <typename config>
 void connection<config>::handle_write_frame (lib::error_code const &ec)
 {
@@ -2000,7 +2022,7 @@ void connection<config>::handle_write_frame (lib::error_code const &ec)
     // release write flag
     m_write_flag = false;
 
-    needs_writing = !m_send_queue.empty();
+    needs_writing = schedule_write();
   }
 
   if (needs_writing) {
@@ -2242,7 +2264,7 @@ lib::error_code connection<config>::send_close_frame (close::status::value code,
   {
     scoped_lock_type lock (m_write_lock);
     write_push (msg);
-    needs_writing = !m_write_flag && !m_send_queue.empty();
+    needs_writing = schedule_write();
   }
 
   if (needs_writing) {
@@ -92,6 +92,9 @@ public:
   /// Type of a shared pointer to an io_service work object
   typedef lib::shared_ptr<lib::asio::io_service::work> work_ptr;
 
+  /// Type of socket pre-bind handler
+  typedef lib::function<lib::error_code (acceptor_ptr) > tcp_pre_bind_handler;
+
   // generate and manage our own io_service
   explicit endpoint()
     : m_io_service (NULL)
@@ -133,6 +136,7 @@ public:
 #ifdef _WEBSOCKETPP_MOVE_SEMANTICS_
   endpoint (endpoint  &&src)
     : config::socket_type (std::move (src) )
+    , m_tcp_pre_bind_handler (src.m_tcp_pre_bind_handler)
     , m_tcp_pre_init_handler (src.m_tcp_pre_init_handler)
     , m_tcp_post_init_handler (src.m_tcp_post_init_handler)
     , m_io_service (src.m_io_service)
@@ -293,6 +297,20 @@ public:
     m_tcp_pre_init_handler = h;
   }
 
+  /// Sets the tcp pre bind handler
+  /**
+   * The tcp pre bind handler is called after the listen acceptor has
+   * been created but before the socket bind is performed.
+   *
+   * @since 0.8.0 (backported)
+   *
+   * @param h The handler to call on tcp pre bind init.
+   */
+  void set_tcp_pre_bind_handler (tcp_pre_bind_handler h)
+  {
+    m_tcp_pre_bind_handler = h;
+  }
+
   /// Sets the tcp pre init handler (deprecated)
   /**
    * The tcp pre init handler is called after the raw tcp connection has been
@@ -437,6 +455,19 @@ public:
                               bec);
     }
 
+    if (!bec && m_tcp_pre_bind_handler) {
+      ec = m_tcp_pre_bind_handler (m_acceptor);
+
+      if (ec) {
+        if (m_acceptor->is_open() ) {
+          m_acceptor->close();
+        }
+
+        log_err (log::elevel::info, "asio listen pre_bind handler", ec);
+        return;
+      }
+    }
+
     if (!bec) {
       m_acceptor->bind (ep, bec);
     }
@@ -1191,6 +1222,7 @@ private:
   };
 
   // Handlers
+  tcp_pre_bind_handler m_tcp_pre_bind_handler;
   tcp_init_handler    m_tcp_pre_init_handler;
   tcp_init_handler    m_tcp_post_init_handler;
 
@@ -67,6 +67,8 @@ F::write_config (const boost::filesystem::path &orig, uint port)
     config.get_child ("mediaServer.net.websocket");
   wsConfig.erase ("port");
   wsConfig.add ("port", port);
+  wsConfig.erase ("reusePort");
+  wsConfig.add ("reusePort", reusePort);
 
   boost::property_tree::ptree &resourceConfig =
     config.get_child ("mediaServer.resources");
@@ -74,6 +76,10 @@ F::write_config (const boost::filesystem::path &orig, uint port)
   resourceConfig.erase ("exceptionLimit");
   resourceConfig.add ("exceptionLimit", resourceLimit);
 
+  if (workerThreads >= 0) {
+    config.put ("mediaServer.workerThreads", workerThreads);
+  }
+
   boost::property_tree::json_parser::write_json (newConfigFile.string(), config);
 
   return newConfigFile;
@@ -172,6 +178,20 @@ Json::Value F::getResponse (const std::string &requestId)
   throw KurentoException (UNEXPECTED_ERROR, "Resonse not found");
 }
 
+Json::Value F::getBatchResponse ()
+{
+  for (auto it = recvMessages.begin(); it != recvMessages.end(); it++) {
+    Json::Value message = *it;
+
+    if (message.isArray () ) {
+      recvMessages.erase (it);
+      return message;
+    }
+  }
+
+  throw KurentoException (UNEXPECTED_ERROR, "Resonse not found");
+}
+
 Json::Value F::getFirstEvent ()
 {
   for (auto it = recvMessages.begin(); it != recvMessages.end(); it++) {
@@ -213,6 +233,30 @@ Json::Value F::sendRequest (const Json::Value &request)
   return response;
 }
 
+Json::Value F::sendBatch (const Json::Value &batch)
+{
+  Json::Value response;
+  std::unique_lock <std::mutex> lock (mutex);
+
+  BOOST_REQUIRE_MESSAGE (initialized, "Not initialized");
+  BOOST_REQUIRE_MESSAGE (!sendingMessage, "Already sending a message");
+
+  sendingMessage = true;
+  client->send (connectionHdl, writer.write (batch),
+                websocketpp::frame::opcode::text);
+
+  if (!cond.wait_for (lock, REPLY_TIMEOUT, std::bind (&F::receivedBatch,
+                      this) ) ) {
+    BOOST_FAIL ("Timeout waiting for response");
+  }
+
+  sendingMessage = false;
+
+  response = getBatchResponse ();
+
+  return response;
+}
+
 Json::Value F::waifForEvent (const std::chrono::seconds timeout)
 {
   Json::Value event;
@@ -302,7 +346,7 @@ void F::stop_client (std::unique_lock <std::mutex> &lock)
 
 bool F::isEvent (const Json::Value &message)
 {
-  if (message.isMember (JSON_RPC_METHOD)
+  if (message.isObject () && message.isMember (JSON_RPC_METHOD)
       && message[JSON_RPC_METHOD] == "onEvent") {
     return true;
   }
@@ -312,6 +356,10 @@ bool F::isEvent (const Json::Value &message)
 
 bool F::isResponse (const Json::Value &message, const std::string &requestId)
 {
+  if (!message.isObject () ) {
+    return false;
+  }
+
   if (message.isMember (JSON_RPC_ERROR)
       || (message.isMember (JSON_RPC_RESULT)
           && message.isMember (JSON_RPC_ID)
@@ -333,6 +381,17 @@ bool F::receivedResponse (const std::string &requestId)
   return false;
 }
 
+bool F::receivedBatch ()
+{
+  for (Json::Value message : recvMessages) {
+    if (message.isArray () ) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 bool F::receivedEvent ()
 {
   for (Json::Value message : recvMessages) {
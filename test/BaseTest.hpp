@@ -42,6 +42,7 @@ protected:
   virtual ~F();
 
   Json::Value sendRequest (const Json::Value &request);
+  Json::Value sendBatch (const Json::Value &batch);
   Json::Value waifForEvent (const std::chrono::seconds timeout);
 
   int getId()
@@ -61,6 +62,22 @@ protected:
     resourceLimit = limit;
   }
 
+  void setReusePort (bool reuse)
+  {
+    reusePort = reuse;
+  }
+
+  /* 0 processes the requests on the network threads */
+  void setWorkerThreads (int threads)
+  {
+    workerThreads = threads;
+  }
+
+  const std::string &getUri ()
+  {
+    return uri;
+  }
+
   void stop();
   void start();
 
@@ -98,6 +115,7 @@ private:
   std::condition_variable cond;
 
   bool receivedResponse (const std::string &requestId);
+  bool receivedBatch ();
 
   bool receivedEvent ();
 
@@ -106,12 +124,16 @@ private:
 
   Json::Value getFirstEvent ();
   Json::Value getResponse (const std::string &requestId);
+  Json::Value getBatchResponse ();
 
   boost::filesystem::path write_config (const boost::filesystem::path &orig,
                                         uint port);
   boost::filesystem::path configDir;
 
   float resourceLimit = 1.0;
+  bool reusePort = false;
+  /* Negative to keep the configured value */
+  int workerThreads = -1;
 };
 
 } /* kurento */
@@ -0,0 +1,282 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE Codec
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+#include "Codec.hpp"
+
+using namespace kurento;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int BENCHMARK_ITERATIONS = 20000;
+
+static std::string
+bytes (std::initializer_list<int> values)
+{
+  std::string str;
+
+  for (int value : values) {
+    str += (char) value;
+  }
+
+  return str;
+}
+
+static Json::Value
+createStatsResponse ()
+{
+  Json::Value response;
+  Json::Value stats;
+
+  response["jsonrpc"] = "2.0";
+  response["id"] = 42;
+
+  for (int i = 0; i < 8; i++) {
+    Json::Value stat;
+    std::string id = "RTCInboundRTPStreamStats_" + std::to_string (i);
+
+    stat["id"] = id;
+    stat["type"] = "inboundrtp";
+    stat["timestamp"] = 1490000000.123 + i;
+    stat["ssrc"] = std::to_string (1234567890 + i);
+    stat["packetsReceived"] = 123456 + i;
+    stat["bytesReceived"] = 98765432 + i;
+    stat["packetsLost"] = i;
+    stat["jitter"] = 0.25;
+    stat["fractionLost"] = 0;
+    stat["isRemote"] = false;
+    stats[id] = stat;
+  }
+
+  response["result"]["value"] = stats;
+  response["result"]["sessionId"] = "6f1a0b3c-1b0e-4a8e-9f4c-2d0c3a9e8f71";
+
+  return response;
+}
+
+static Json::Value
+createEvent ()
+{
+  Json::Value event;
+  Json::Value value;
+
+  value["data"]["source"] =
+    "4f1d8b2e-3c5a-4b6e-8d7f-9a0b1c2d3e4f_kurento.WebRtcEndpoint";
+  value["data"]["candidate"]["candidate"] =
+    "candidate:1 1 UDP 2013266431 192.168.1.10 45678 typ host";
+  value["data"]["candidate"]["sdpMid"] = "video";
+  value["data"]["candidate"]["sdpMLineIndex"] = 1;
+  value["data"]["type"] = "IceCandidateFound";
+  value["object"] = value["data"]["source"];
+  value["type"] = "IceCandidateFound";
+
+  event["jsonrpc"] = "2.0";
+  event["method"] = "onEvent";
+  event["params"]["value"] = value;
+
+  return event;
+}
+
+static void
+checkRoundTrip (std::shared_ptr<Codec> codec, const Json::Value &value)
+{
+  std::string encoded;
+  Json::Value decoded;
+
+  codec->encode (value, encoded);
+  BOOST_REQUIRE (codec->decode (encoded, decoded) );
+  BOOST_CHECK (decoded == value);
+}
+
+static double
+measureEncode (std::shared_ptr<Codec> codec, const Json::Value &value)
+{
+  std::string encoded;
+  Clock::time_point start = Clock::now ();
+
+  for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+    codec->encode (value, encoded);
+  }
+
+  return std::chrono::duration<double, std::micro> (Clock::now () - start).count
+         () / BENCHMARK_ITERATIONS;
+}
+
+static double
+measureDecode (std::shared_ptr<Codec> codec, const Json::Value &value)
+{
+  std::string encoded;
+  Clock::time_point start;
+
+  codec->encode (value, encoded);
+  start = Clock::now ();
+
+  for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+    Json::Value decoded;
+
+    codec->decode (encoded, decoded);
+  }
+
+  return std::chrono::duration<double, std::micro> (Clock::now () - start).count
+         () / BENCHMARK_ITERATIONS;
+}
+
+BOOST_AUTO_TEST_CASE (codec_registry)
+{
+  BOOST_REQUIRE (Codec::getJsonCodec () );
+  BOOST_CHECK (Codec::getCodec ("") == Codec::getJsonCodec () );
+  BOOST_CHECK (Codec::getCodec ("kurento-json") == Codec::getJsonCodec () );
+  BOOST_REQUIRE (Codec::getCodec ("kurento-cbor") );
+  BOOST_CHECK (Codec::getCodec ("kurento-cbor")->isBinary () );
+  BOOST_CHECK (!Codec::getJsonCodec ()->isBinary () );
+  BOOST_CHECK (!Codec::getCodec ("unknown") );
+}
+
+BOOST_AUTO_TEST_CASE (cbor_known_values)
+{
+  std::shared_ptr<Codec> cbor = Codec::getCodec ("kurento-cbor");
+  std::string encoded;
+  Json::Value value;
+
+  /* Examples from RFC 7049, appendix A */
+  cbor->encode (Json::Value (0), encoded);
+  BOOST_CHECK (encoded == bytes ({0x00}) );
+  cbor->encode (Json::Value (-1), encoded);
+  BOOST_CHECK (encoded == bytes ({0x20}) );
+  cbor->encode (Json::Value (1000), encoded);
+  BOOST_CHECK (encoded == bytes ({0x19, 0x03, 0xe8}) );
+  cbor->encode (Json::Value ("a"), encoded);
+  BOOST_CHECK (encoded == bytes ({0x61, 0x61}) );
+  cbor->encode (Json::Value (true), encoded);
+  BOOST_CHECK (encoded == bytes ({0xf5}) );
+  cbor->encode (Json::Value::null, encoded);
+  BOOST_CHECK (encoded == bytes ({0xf6}) );
+  cbor->encode (Json::Value (1.5), encoded);
+  BOOST_CHECK (encoded == bytes ({0xfa, 0x3f, 0xc0, 0x00, 0x00}) );
+
+  BOOST_REQUIRE (cbor->decode (bytes ({0xf9, 0x3e, 0x00}), value) );
+  BOOST_CHECK_EQUAL (value.asDouble (), 1.5);
+  BOOST_REQUIRE (cbor->decode (bytes ({0x3a, 0x00, 0x0f, 0x42, 0x3f}), value) );
+  BOOST_CHECK_EQUAL (value.asInt (), -1000000);
+
+  /* Indefinite length array [1, [2, 3]] and map {"a": 1} */
+  BOOST_REQUIRE (cbor->decode (bytes ({0x9f, 0x01, 0x82, 0x02, 0x03, 0xff}),
+                               value) );
+  BOOST_REQUIRE (value.isArray () );
+  BOOST_CHECK_EQUAL (value[1][1].asInt (), 3);
+  BOOST_REQUIRE (cbor->decode (bytes ({0xbf, 0x61, 0x61, 0x01, 0xff}), value) );
+  BOOST_CHECK_EQUAL (value["a"].asInt (), 1);
+}
+
+BOOST_AUTO_TEST_CASE (cbor_round_trip)
+{
+  std::shared_ptr<Codec> cbor = Codec::getCodec ("kurento-cbor");
+  Json::Value value;
+
+  value["int"] = -123456;
+  value["large"] = Json::Value (Json::Int64 (1) << 40);
+  value["real"] = 0.1;
+  value["single"] = 0.5;
+  value["string"] = std::string ("with\0nul", 8);
+  value["empty"] = "";
+  value["bool"] = false;
+  value["null"] = Json::Value::null;
+  value["array"].append (1);
+  value["array"].append ("two");
+  value["array"].append (Json::Value (Json::objectValue) );
+  value["array"].append (Json::Value (Json::arrayValue) );
+
+  checkRoundTrip (cbor, value);
+  checkRoundTrip (cbor, createStatsResponse () );
+  checkRoundTrip (cbor, createEvent () );
+}
+
+BOOST_AUTO_TEST_CASE (cbor_invalid_input)
+{
+  std::shared_ptr<Codec> cbor = Codec::getCodec ("kurento-cbor");
+  std::string encoded;
+  Json::Value value;
+
+  BOOST_CHECK (!cbor->decode ("", value) );
+  /* Byte strings have no JSON equivalent */
+  BOOST_CHECK (!cbor->decode (bytes ({0x41, 0x00}), value) );
+  /* Trailing data */
+  BOOST_CHECK (!cbor->decode (bytes ({0x00, 0x00}), value) );
+  /* Map keys must be text */
+  BOOST_CHECK (!cbor->decode (bytes ({0xa1, 0x01, 0x01}), value) );
+
+  cbor->encode (createEvent (), encoded);
+
+  for (size_t i = 0; i < encoded.size (); i++) {
+    BOOST_CHECK (!cbor->decode (encoded.substr (0, i), value) );
+  }
+
+  BOOST_CHECK (!cbor->decode (std::string (2000, (char) 0x81), value) );
+}
+
+BOOST_AUTO_TEST_CASE (encode_array)
+{
+  for (const char *name : {
+         "kurento-json", "kurento-cbor"
+       }) {
+    std::shared_ptr<Codec> codec = Codec::getCodec (name);
+    std::vector<std::string> items (2);
+    std::string encoded;
+    Json::Value value;
+
+    codec->encode (Json::Value (1), items[0]);
+    codec->encode (createEvent (), items[1]);
+    codec->encodeArray (items, encoded);
+
+    BOOST_REQUIRE (codec->decode (encoded, value) );
+    BOOST_REQUIRE (value.isArray () );
+    BOOST_CHECK_EQUAL (value.size (), 2);
+    BOOST_CHECK_EQUAL (value[0].asInt (), 1);
+    BOOST_CHECK (value[1] == createEvent () );
+  }
+}
+
+BOOST_AUTO_TEST_CASE (benchmark_codecs)
+{
+  std::shared_ptr<Codec> json = Codec::getJsonCodec ();
+  std::shared_ptr<Codec> cbor = Codec::getCodec ("kurento-cbor");
+  std::vector<std::pair<std::string, Json::Value>> messages = {
+    {"getStats response", createStatsResponse () },
+    {"onEvent", createEvent () }
+  };
+
+  for (auto &message : messages) {
+    std::string jsonStr;
+    std::string cborStr;
+
+    json->encode (message.second, jsonStr);
+    cbor->encode (message.second, cborStr);
+
+    BOOST_TEST_MESSAGE (message.first << ": json " << jsonStr.size () <<
+                        " bytes, encode " << measureEncode (json, message.second) <<
+                        " us, decode " << measureDecode (json, message.second) <<
+                        " us; cbor " << cborStr.size () << " bytes, encode " <<
+                        measureEncode (cbor, message.second) << " us, decode " <<
+                        measureDecode (cbor, message.second) << " us");
+
+    BOOST_CHECK_LT (cborStr.size (), jsonStr.size () );
+  }
+}
@@ -0,0 +1,202 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE ConnectionRegistry
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+#include "ConnectionRegistry.hpp"
+
+using namespace kurento;
+
+static std::shared_ptr<void>
+createConnection ()
+{
+  return std::shared_ptr<int> (new int (0) );
+}
+
+BOOST_AUTO_TEST_CASE (associate_and_find)
+{
+  ConnectionRegistry registry;
+  std::shared_ptr<void> connection = createConnection ();
+
+  BOOST_CHECK (!registry.find ("session") );
+  BOOST_CHECK (!registry.find (connection) );
+
+  BOOST_CHECK (registry.associate ("session", connection, true) );
+  BOOST_REQUIRE (registry.find ("session") );
+  BOOST_CHECK (registry.find ("session") == registry.find (connection) );
+  BOOST_CHECK (registry.find ("session")->hdl.lock () == connection);
+  BOOST_CHECK (registry.find ("session")->secure);
+
+  /* Nothing changes */
+  BOOST_CHECK (!registry.associate ("session", connection, true) );
+
+  /* Only the secure flag changes */
+  BOOST_CHECK (!registry.associate ("session", connection, false) );
+  BOOST_CHECK (!registry.find ("session")->secure);
+}
+
+BOOST_AUTO_TEST_CASE (reassociate)
+{
+  ConnectionRegistry registry;
+  std::shared_ptr<void> first = createConnection ();
+  std::shared_ptr<void> second = createConnection ();
+
+  registry.associate ("session", first, false);
+
+  /* The session reconnects */
+  BOOST_CHECK (registry.associate ("session", second, false) );
+  BOOST_CHECK (registry.find ("session")->hdl.lock () == second);
+  BOOST_CHECK (!registry.find (first) );
+
+  /* The connection starts another session */
+  BOOST_CHECK (registry.associate ("other", second, false) );
+  BOOST_CHECK (!registry.find ("session") );
+  BOOST_CHECK_EQUAL (registry.find (second)->sessionId, "other");
+  BOOST_CHECK_EQUAL (registry.getSessionIds ().size (), 1);
+}
+
+BOOST_AUTO_TEST_CASE (remove_connection)
+{
+  ConnectionRegistry registry;
+  std::shared_ptr<void> connection = createConnection ();
+  std::shared_ptr<ConnectionRegistry::Record> record;
+
+  registry.associate ("session", connection, false);
+  registry.find ("session")->addSent (10);
+  registry.find ("session")->addWrite ();
+
+  record = registry.remove (connection);
+  BOOST_REQUIRE (record);
+  BOOST_CHECK_EQUAL (record->messagesSent.load (), 1);
+  BOOST_CHECK_EQUAL (record->bytesSent.load (), 10);
+  BOOST_CHECK_EQUAL (record->writes.load (), 1);
+  BOOST_CHECK (!registry.find ("session") );
+  BOOST_CHECK (!registry.find (connection) );
+  BOOST_CHECK (!registry.remove (connection) );
+
+  /* Closed connections are not added back */
+  BOOST_CHECK (!registry.associate ("late", std::weak_ptr<void> (), false) );
+  BOOST_CHECK (!registry.find ("late") );
+}
+
+BOOST_AUTO_TEST_CASE (associate_after_remove)
+{
+  ConnectionRegistry registry;
+  std::shared_ptr<void> connection = createConnection ();
+  std::shared_ptr<void> other = createConnection ();
+
+  /* A response completing after its connection was closed */
+  registry.associate ("session", connection, false);
+  registry.remove (connection);
+  BOOST_CHECK (!registry.associate ("session", connection, false) );
+  BOOST_CHECK (!registry.find ("session") );
+  BOOST_CHECK (!registry.find (connection) );
+
+  /* Also when the connection never had a session */
+  registry.remove (other);
+  BOOST_CHECK (!registry.associate ("other", other, false) );
+  BOOST_CHECK (registry.getSessionIds ().empty () );
+}
+
+BOOST_AUTO_TEST_CASE (concurrent_associations)
+{
+  ConnectionRegistry registry;
+  std::vector<std::shared_ptr<void>> connections;
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 4; i++) {
+    connections.push_back (createConnection () );
+  }
+
+  /* The same sessions moving between the same connections */
+  for (int t = 0; t < 4; t++) {
+    threads.push_back (std::thread ([&registry, &connections, t] () {
+      for (int i = 0; i < 5000; i++) {
+        registry.associate ("session" + std::to_string ( (i + t) % 3),
+                            connections[ (i * 7 + t) % 4], false);
+      }
+    }) );
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join ();
+  }
+
+  for (const std::string &sessionId : registry.getSessionIds () ) {
+    std::shared_ptr<ConnectionRegistry::Record> record = registry.find (
+          sessionId);
+
+    BOOST_REQUIRE (record);
+    BOOST_CHECK (registry.find (record->hdl) == record);
+  }
+
+  for (std::shared_ptr<void> &connection : connections) {
+    std::shared_ptr<ConnectionRegistry::Record> record = registry.find (
+          connection);
+
+    if (record) {
+      BOOST_CHECK (registry.find (record->sessionId) == record);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE (concurrent_lookups)
+{
+  ConnectionRegistry registry;
+  std::vector<std::shared_ptr<void>> connections;
+  std::vector<std::thread> threads;
+  std::atomic<bool> done (false);
+  std::atomic<int> missing (0);
+
+  for (int i = 0; i < 64; i++) {
+    connections.push_back (createConnection () );
+    registry.associate ("stable" + std::to_string (i), connections.back (), false);
+  }
+
+  for (int t = 0; t < 4; t++) {
+    threads.push_back (std::thread ([&registry, &done, &missing] () {
+      while (!done) {
+        for (int i = 0; i < 64; i++) {
+          if (!registry.find ("stable" + std::to_string (i) ) ) {
+            missing++;
+          }
+        }
+      }
+    }) );
+  }
+
+  /* Sessions coming and going while the others are looked up */
+  for (int i = 0; i < 2000; i++) {
+    std::shared_ptr<void> connection = createConnection ();
+
+    registry.associate ("transient" + std::to_string (i), connection, false);
+    BOOST_REQUIRE (registry.find (connection) );
+    registry.remove (connection);
+  }
+
+  done = true;
+
+  for (std::thread &thread : threads) {
+    thread.join ();
+  }
+
+  BOOST_CHECK_EQUAL (missing.load (), 0);
+  BOOST_CHECK_EQUAL (registry.getSessionIds ().size (), 64);
+}
@@ -0,0 +1,248 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE JsonBuffers
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "JsonBuffers.hpp"
+
+using namespace kurento;
+
+/* Count heap allocations to report the cost of processing a message */
+static std::atomic<long> allocations (0);
+
+static void *
+countedMalloc (std::size_t size) noexcept
+{
+  allocations++;
+
+  return malloc (size);
+}
+
+/*
+ * Not inlined, so that GCC does not see a free of memory returned by operator
+ * new and report it as a mismatched deallocation
+ */
+__attribute__ ( (noinline) ) static void
+countedFree (void *ptr) noexcept
+{
+  free (ptr);
+}
+
+void *
+operator new (std::size_t size)
+{
+  void *ptr = countedMalloc (size);
+
+  if (ptr == nullptr) {
+    throw std::bad_alloc ();
+  }
+
+  return ptr;
+}
+
+void *
+operator new[] (std::size_t size)
+{
+  void *ptr = countedMalloc (size);
+
+  if (ptr == nullptr) {
+    throw std::bad_alloc ();
+  }
+
+  return ptr;
+}
+
+void *
+operator new (std::size_t size, const std::nothrow_t &) noexcept
+{
+  return countedMalloc (size);
+}
+
+void *
+operator new[] (std::size_t size, const std::nothrow_t &) noexcept
+{
+  return countedMalloc (size);
+}
+
+void
+operator delete (void *ptr) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete[] (void *ptr) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete (void *ptr, const std::nothrow_t &) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete[] (void *ptr, const std::nothrow_t &) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete (void *ptr, std::size_t) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete[] (void *ptr, std::size_t) noexcept
+{
+  countedFree (ptr);
+}
+
+static const std::string REQUEST =
+  "{\"jsonrpc\":\"2.0\",\"id\":12,\"method\":\"invoke\",\"params\":"
+  "{\"object\":\"c5b9b9b6-4c13-4a25-ab1a-c4a6a6e7ee0c_kurento.MediaPipeline/"
+  "7e8d3b12-0a42-4bb8-8bd3-4b8b7c3fbb1d_kurento.WebRtcEndpoint\","
+  "\"operation\":\"addIceCandidate\",\"operationParams\":{\"candidate\":"
+  "{\"candidate\":\"candidate:1 1 UDP 2013266431 192.168.1.10 50000 typ host\","
+  "\"sdpMid\":\"video\",\"sdpMLineIndex\":1,\"__module__\":\"kurento\","
+  "\"__type__\":\"IceCandidate\"}},"
+  "\"sessionId\":\"0f6cdf1d-1c1a-4e52-9e6b-2bfbc4f1a5b0\"}}";
+
+static Json::Value
+createResponse (const Json::Value &request)
+{
+  Json::Value response;
+
+  response["jsonrpc"] = "2.0";
+  response["id"] = request["id"];
+  response["result"]["sessionId"] = request["params"]["sessionId"];
+
+  return response;
+}
+
+BOOST_AUTO_TEST_CASE (write_json)
+{
+  Json::Value value;
+  Json::Value parsed;
+  std::string out;
+
+  value["string"] = "quote \" backslash \\ newline \n tab \t control \x01 utf8 \xc3\xb1";
+  value["int"] = -42;
+  value["uint"] = Json::UInt64 (18446744073709551615ULL);
+  value["real"] = 0.1;
+  value["bool"] = true;
+  value["null"] = Json::Value::null;
+  value["array"].append (1);
+  value["array"].append ("two");
+  value["array"].append (Json::Value (Json::objectValue) );
+  value["empty"] = Json::Value (Json::arrayValue);
+
+  writeJson (value, out);
+
+  BOOST_REQUIRE (parseJson (out, parsed) );
+  BOOST_CHECK (parsed == value);
+  BOOST_CHECK_EQUAL (out.find ('\n'), std::string::npos);
+
+  writeJson (Json::Value ("short"), out);
+  BOOST_CHECK_EQUAL (out, "\"short\"");
+}
+
+BOOST_AUTO_TEST_CASE (embedded_nul)
+{
+  Json::Value value;
+  Json::Value parsed;
+  std::string out;
+
+  BOOST_REQUIRE (parseJson ("{\"a\\u0000b\": \"x\\u0000y\"}", value) );
+  BOOST_REQUIRE_EQUAL (value.getMemberNames ().front ().size (), 3);
+
+  writeJson (value, out);
+
+  BOOST_CHECK_EQUAL (out, "{\"a\\u0000b\":\"x\\u0000y\"}");
+  BOOST_REQUIRE (parseJson (out, parsed) );
+  BOOST_CHECK (parsed == value);
+}
+
+/*
+ * Allocations to parse a request and write its response, creating a reader
+ * and a writer for each message as before, and reusing the per-thread state
+ */
+BOOST_AUTO_TEST_CASE (allocations_per_message)
+{
+  const int nMessages = 10000;
+  std::string out;
+  long before;
+
+  /* Warm up the per-thread state */
+  for (int i = 0; i < 10; i++) {
+    Json::Value request;
+
+    parseJson (REQUEST, request);
+    writeJson (createResponse (request), out);
+  }
+
+  before = allocations;
+
+  for (int i = 0; i < nMessages; i++) {
+    Json::Reader reader;
+    Json::FastWriter writer;
+    Json::Value request;
+
+    reader.parse (REQUEST, request);
+    out = writer.write (createResponse (request) );
+  }
+
+  double fresh = (double) (allocations - before) / nMessages;
+
+  before = allocations;
+
+  for (int i = 0; i < nMessages; i++) {
+    Json::Value request;
+
+    parseJson (REQUEST, request);
+    writeJson (createResponse (request), out);
+  }
+
+  double reused = (double) (allocations - before) / nMessages;
+
+  BOOST_TEST_MESSAGE ("Allocations per message: " << fresh <<
+                      " with a new reader and writer, " << reused <<
+                      " reusing them");
+
+  BOOST_CHECK_LT (reused, fresh);
+}
+
+BOOST_AUTO_TEST_CASE (recycle_buffer)
+{
+  std::string buffer (JSON_BUFFER_MAX_CAPACITY + 1, 'x');
+
+  recycleBuffer (buffer);
+  BOOST_CHECK (buffer.empty () );
+  BOOST_CHECK_LE (buffer.capacity (), (size_t) JSON_BUFFER_MAX_CAPACITY);
+
+  buffer = "small";
+  recycleBuffer (buffer);
+  BOOST_CHECK (buffer.empty () );
+  BOOST_CHECK_GT (buffer.capacity (), (size_t) 0);
+}
@@ -0,0 +1,90 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE Metrics
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+#include "Metrics.hpp"
+
+using namespace kurento;
+
+BOOST_AUTO_TEST_CASE (histogram_buckets)
+{
+  /* Bucket bounds are contiguous and within the 12.5% error */
+  for (unsigned int i = 1; i < Histogram::BUCKETS - 1; i++) {
+    uint64_t first = Histogram::getBucketMax (i - 1) + 1;
+
+    BOOST_REQUIRE_EQUAL (Histogram::getBucket (first), i);
+    BOOST_REQUIRE_EQUAL (Histogram::getBucket (Histogram::getBucketMax (i) ), i);
+    BOOST_REQUIRE_LE (Histogram::getBucketMax (i) - first, first / 8);
+  }
+
+  BOOST_CHECK_EQUAL (Histogram::getBucket (UINT64_MAX), Histogram::BUCKETS - 1);
+}
+
+BOOST_AUTO_TEST_CASE (histogram_percentiles)
+{
+  Histogram histogram;
+  Histogram::Snapshot snapshot;
+
+  for (uint64_t i = 1; i <= 1000; i++) {
+    histogram.record (i);
+  }
+
+  snapshot = histogram.getSnapshot ();
+
+  BOOST_CHECK_EQUAL (snapshot.count, 1000u);
+  BOOST_CHECK_EQUAL (snapshot.sum, 500500u);
+  BOOST_CHECK_EQUAL (snapshot.max, 1000u);
+  BOOST_CHECK_CLOSE (snapshot.mean (), 500.5, 0.001);
+  BOOST_CHECK_CLOSE ( (double) snapshot.percentile (0.5), 500, 12.5);
+  BOOST_CHECK_CLOSE ( (double) snapshot.percentile (0.99), 990, 12.5);
+  BOOST_CHECK_EQUAL (snapshot.percentile (1), 1000u);
+
+  BOOST_CHECK_EQUAL (Histogram ().getSnapshot ().percentile (0.5), 0u);
+}
+
+BOOST_AUTO_TEST_CASE (concurrent_recording)
+{
+  Histogram histogram;
+  Counter counter;
+  std::vector<std::thread> threads;
+  Histogram::Snapshot snapshot;
+
+  for (int i = 0; i < 16; i++) {
+    threads.push_back (std::thread ([&histogram, &counter, i] () {
+      for (int j = 0; j < 100000; j++) {
+        histogram.record (i);
+        counter.add ();
+      }
+    }) );
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join ();
+  }
+
+  snapshot = histogram.getSnapshot ();
+
+  BOOST_CHECK_EQUAL (counter.get (), 1600000u);
+  BOOST_CHECK_EQUAL (snapshot.count, 1600000u);
+  BOOST_CHECK_EQUAL (snapshot.max, 15u);
+  BOOST_CHECK_EQUAL (snapshot.sum, 100000u * 120);
+}
@@ -0,0 +1,78 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE ObjectAliases
+#include <boost/test/unit_test.hpp>
+
+#include "ObjectAliases.hpp"
+
+using namespace kurento;
+
+static const std::string PIPELINE =
+  "4f1d8b2e-3c5a-4b6e-8d7f-9a0b1c2d3e4f_kurento.MediaPipeline";
+static const std::string ENDPOINT = PIPELINE +
+                                    "/9a0b1c2d-3e4f-4f1d-8b2e-3c5a4b6e8d7f_kurento.WebRtcEndpoint";
+
+BOOST_AUTO_TEST_CASE (assign_aliases)
+{
+  ObjectAliases aliases;
+  std::string objectId;
+
+  BOOST_CHECK_EQUAL (aliases.findAlias (PIPELINE), 0u);
+  BOOST_CHECK_EQUAL (aliases.getAlias (PIPELINE), 1u);
+  BOOST_CHECK_EQUAL (aliases.getAlias (ENDPOINT), 2u);
+  BOOST_CHECK_EQUAL (aliases.getAlias (PIPELINE), 1u);
+  BOOST_CHECK_EQUAL (aliases.findAlias (ENDPOINT), 2u);
+
+  BOOST_REQUIRE (aliases.getObjectId (2, objectId) );
+  BOOST_CHECK_EQUAL (objectId, ENDPOINT);
+  BOOST_CHECK (!aliases.getObjectId (0, objectId) );
+  BOOST_CHECK (!aliases.getObjectId (3, objectId) );
+}
+
+BOOST_AUTO_TEST_CASE (remove_object)
+{
+  ObjectAliases aliases;
+  std::string objectId;
+
+  aliases.getAlias (PIPELINE);
+  aliases.getAlias (ENDPOINT);
+
+  /* Children go away with their pipeline */
+  aliases.removeObject (PIPELINE);
+
+  BOOST_CHECK (!aliases.getObjectId (1, objectId) );
+  BOOST_CHECK (!aliases.getObjectId (2, objectId) );
+  BOOST_CHECK_EQUAL (aliases.findAlias (ENDPOINT), 0u);
+
+  /* Aliases are not reused */
+  BOOST_CHECK_EQUAL (aliases.getAlias (PIPELINE), 3u);
+}
+
+BOOST_AUTO_TEST_CASE (saved_bytes)
+{
+  ObjectAliases aliases;
+  uint64_t total = ObjectAliases::getTotalSavedBytes ();
+  uint64_t alias = aliases.getAlias (ENDPOINT);
+
+  aliases.addSavedBytes (alias, ENDPOINT);
+  aliases.addSavedBytes (alias, ENDPOINT);
+
+  BOOST_CHECK_EQUAL (aliases.getSavedBytes (), 2 * (ENDPOINT.size () + 1) );
+  BOOST_CHECK_EQUAL (ObjectAliases::getTotalSavedBytes () - total,
+                     aliases.getSavedBytes () );
+}
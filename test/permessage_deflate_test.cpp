@@ -0,0 +1,112 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE PermessageDeflate
+#include <boost/test/unit_test.hpp>
+
+#include "PermessageDeflate.hpp"
+
+using namespace kurento;
+
+typedef websocketpp::config::core::permessage_deflate_config DeflateConfig;
+typedef PermessageDeflate<DeflateConfig> Extension;
+typedef websocketpp::extensions::permessage_deflate::enabled<DeflateConfig>
+ClientExtension;
+
+static std::string
+createStatsMessage ()
+{
+  std::string message = "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":{\"value\":{";
+
+  for (int i = 0; i < 16; i++) {
+    message += "\"RTCInboundRTPStreamStats_" + std::to_string (i) +
+               "\":{\"type\":\"inboundrtp\",\"packetsReceived\":" +
+               std::to_string (1000 + i) + ",\"packetsLost\":0,\"jitter\":0.25},";
+  }
+
+  message += "\"end\":true}}}";
+
+  return message;
+}
+
+/* What hybi13 does with the output before writing the frame */
+static std::string
+compress (Extension &extension, const std::string &message)
+{
+  std::string out;
+
+  BOOST_REQUIRE (!extension.compress (message, out) );
+  out.resize (out.size () - 4);
+
+  return out;
+}
+
+static std::string
+decompress (ClientExtension &extension, std::string compressed)
+{
+  std::string out;
+  static const uint8_t trailer[4] = {0x00, 0x00, 0xff, 0xff};
+
+  BOOST_REQUIRE (!extension.decompress ( (const uint8_t *) compressed.data (),
+                                         compressed.size (), out) );
+  BOOST_REQUIRE (!extension.decompress (trailer, 4, out) );
+
+  return out;
+}
+
+BOOST_AUTO_TEST_CASE (disabled_by_default)
+{
+  Extension extension;
+
+  BOOST_CHECK (!extension.is_implemented () );
+}
+
+BOOST_AUTO_TEST_CASE (compress_messages)
+{
+  PermessageDeflateSettings &settings = PermessageDeflateSettings::get ();
+  websocketpp::http::attribute_list offer;
+  std::string message = createStatsMessage ();
+  Json::Value stats;
+
+  settings.enabled = true;
+  settings.windowBits = 10;
+
+  Extension server;
+  ClientExtension client;
+
+  BOOST_REQUIRE (server.is_implemented () );
+  BOOST_REQUIRE (!server.negotiate (offer).first);
+  BOOST_REQUIRE (!server.init (true) );
+  BOOST_REQUIRE (!client.negotiate (offer).first);
+  BOOST_REQUIRE (!client.init (false) );
+
+  for (int i = 0; i < 10; i++) {
+    std::string compressed = compress (server, message);
+
+    BOOST_CHECK_LT (compressed.size (), message.size () / 2);
+    BOOST_CHECK_EQUAL (decompress (client, compressed), message);
+  }
+
+  CompressionStats::getStats (stats);
+  BOOST_CHECK_EQUAL (stats["messages"].asUInt64 (), 10);
+  BOOST_CHECK_EQUAL (stats["bytesIn"].asUInt64 (), 10 * message.size () );
+  BOOST_CHECK_LT (stats["ratio"].asDouble (), 0.5);
+  BOOST_CHECK_GE (stats["cpuMs"].asDouble (), 0);
+
+  BOOST_TEST_MESSAGE ("Compression ratio " << stats["ratio"].asDouble () <<
+                      ", " << stats["cpuMs"].asDouble () * 1000 / 10 << " us per message");
+}
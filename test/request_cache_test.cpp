@@ -0,0 +1,288 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE RequestCache
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include <json/json.h>
+
+#include "RequestCache.hpp"
+#include "CacheEntry.hpp"
+
+using namespace kurento;
+
+typedef std::chrono::steady_clock Clock;
+
+/* Count heap allocations to report the cost of caching a response */
+static std::atomic<long> allocations (0);
+
+static void *
+countedMalloc (std::size_t size) noexcept
+{
+  allocations++;
+
+  return malloc (size);
+}
+
+/*
+ * Not inlined, so that GCC does not see a free of memory returned by operator
+ * new and report it as a mismatched deallocation
+ */
+__attribute__ ( (noinline) ) static void
+countedFree (void *ptr) noexcept
+{
+  free (ptr);
+}
+
+void *
+operator new (std::size_t size)
+{
+  void *ptr = countedMalloc (size);
+
+  if (ptr == nullptr) {
+    throw std::bad_alloc ();
+  }
+
+  return ptr;
+}
+
+void *
+operator new[] (std::size_t size)
+{
+  void *ptr = countedMalloc (size);
+
+  if (ptr == nullptr) {
+    throw std::bad_alloc ();
+  }
+
+  return ptr;
+}
+
+void *
+operator new (std::size_t size, const std::nothrow_t &) noexcept
+{
+  return countedMalloc (size);
+}
+
+void *
+operator new[] (std::size_t size, const std::nothrow_t &) noexcept
+{
+  return countedMalloc (size);
+}
+
+void
+operator delete (void *ptr) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete[] (void *ptr) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete (void *ptr, const std::nothrow_t &) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete[] (void *ptr, const std::nothrow_t &) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete (void *ptr, std::size_t) noexcept
+{
+  countedFree (ptr);
+}
+
+void
+operator delete[] (void *ptr, std::size_t) noexcept
+{
+  countedFree (ptr);
+}
+
+static std::string
+createResponse (const std::string &requestId)
+{
+  Json::Value response;
+  Json::FastWriter writer;
+
+  response["jsonrpc"] = "2.0";
+  response["id"] = requestId;
+  response["result"]["sessionId"] = "session";
+  response["result"]["value"] = "object";
+
+  return writer.write (response);
+}
+
+BOOST_AUTO_TEST_CASE (cached_bytes)
+{
+  RequestCache cache (3000, 1000);
+  std::string response = createResponse ("1");
+  std::shared_ptr<CacheEntry> entry;
+
+  cache.addResponse ("session", "1", response, "newSession");
+  entry = cache.getCachedResponse ("session", "1");
+
+  BOOST_CHECK_EQUAL (entry->getResponse (), response);
+  BOOST_CHECK_EQUAL (entry->getResponseSessionId (), "newSession");
+
+  BOOST_CHECK (!cache.findCachedResponse ("session", "2") );
+  BOOST_CHECK (!cache.findCachedResponse ("otherSession", "1") );
+  BOOST_CHECK_THROW (cache.getCachedResponse ("session", "2"), CacheException);
+}
+
+static bool
+isCached (RequestCache &cache, const std::string &sessionId,
+          const std::string &requestId)
+{
+  return cache.findCachedResponse (sessionId, requestId) != nullptr;
+}
+
+BOOST_AUTO_TEST_CASE (expire_after_timeout)
+{
+  RequestCache cache (3000, 1000);
+  std::string response = createResponse ("1");
+
+  cache.addResponse ("session", "1", response, "session");
+
+  for (int i = 0; i < 3; i++) {
+    cache.expire ();
+    BOOST_CHECK (isCached (cache, "session", "1") );
+  }
+
+  cache.expire ();
+  BOOST_CHECK (!isCached (cache, "session", "1") );
+}
+
+BOOST_AUTO_TEST_CASE (replaced_entry_keeps_its_timeout)
+{
+  RequestCache cache (3000, 1000);
+  std::string response = createResponse ("1");
+
+  cache.addResponse ("session", "1", response, "session");
+  cache.expire ();
+  cache.addResponse ("session", "1", response, "session");
+
+  for (int i = 0; i < 3; i++) {
+    cache.expire ();
+    BOOST_CHECK (isCached (cache, "session", "1") );
+  }
+
+  cache.expire ();
+  BOOST_CHECK (!isCached (cache, "session", "1") );
+}
+
+BOOST_AUTO_TEST_CASE (add_response_cost)
+{
+  const int nResponses = 100000;
+  RequestCache cache (20000, 1000);
+  std::vector<std::string> ids;
+  std::string response = createResponse ("id");
+
+  for (int i = 0; i < nResponses; i++) {
+    ids.push_back (std::to_string (i) );
+  }
+
+  long allocationsBefore = allocations;
+  Clock::time_point start = Clock::now();
+
+  for (int i = 0; i < nResponses; i++) {
+    cache.addResponse ("session" + std::to_string (i % 100), ids[i], response,
+                       "session");
+  }
+
+  std::chrono::duration<double, std::nano> addTime = Clock::now() - start;
+  long addAllocations = allocations - allocationsBefore;
+
+  start = Clock::now();
+
+  for (int i = 0; i < 21; i++) {
+    cache.expire ();
+  }
+
+  std::chrono::duration<double, std::nano> expireTime = Clock::now() - start;
+
+  BOOST_TEST_MESSAGE ("Cached " << nResponses << " responses: " <<
+                      addTime.count() / nResponses << " ns and " <<
+                      (double) addAllocations / nResponses <<
+                      " allocations per response, " <<
+                      expireTime.count() / nResponses << " ns per expiration");
+
+  BOOST_CHECK (!isCached (cache, "session0", ids[0]) );
+}
+
+static double
+lookupCost (int nSessions, int nRequests)
+{
+  const int nLookups = 200000;
+  RequestCache cache (20000, 1000);
+  std::vector<std::string> sessions;
+  std::vector<std::string> requests;
+  std::string response = createResponse ("id");
+
+  for (int i = 0; i < nSessions; i++) {
+    sessions.push_back ("session" + std::to_string (i) );
+  }
+
+  for (int i = 0; i < nRequests; i++) {
+    requests.push_back (std::to_string (i) );
+  }
+
+  for (const std::string &session : sessions) {
+    for (const std::string &request : requests) {
+      cache.addResponse (session, request, response, "session");
+    }
+  }
+
+  Clock::time_point start = Clock::now();
+
+  for (int i = 0; i < nLookups; i++) {
+    std::shared_ptr<CacheEntry> entry = cache.getCachedResponse (
+                                          sessions[i % nSessions], requests[i % nRequests]);
+
+    BOOST_REQUIRE (entry);
+  }
+
+  std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+
+  BOOST_TEST_MESSAGE ("Lookup with " << nSessions << " sessions and " <<
+                      nRequests << " requests per session: " <<
+                      elapsed.count() / nLookups << " ns");
+
+  return elapsed.count() / nLookups;
+}
+
+BOOST_AUTO_TEST_CASE (lookup_cost)
+{
+  double small = lookupCost (10, 10);
+  double large = lookupCost (1000, 100);
+
+  /* Hashed shards should keep the lookup cost flat */
+  BOOST_TEST_MESSAGE ("Lookup cost ratio, large to small cache: " <<
+                      large / small);
+}
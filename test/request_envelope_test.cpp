@@ -0,0 +1,166 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE RequestEnvelope
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+#include "RequestEnvelope.hpp"
+
+using namespace kurento;
+
+typedef std::chrono::steady_clock Clock;
+
+BOOST_AUTO_TEST_CASE (scan_fields)
+{
+  RequestEnvelope envelope;
+
+  BOOST_REQUIRE (envelope.scan (
+                   "{\"jsonrpc\": \"2.0\", \"id\": 3, \"method\": \"invoke\", "
+                   "\"params\": {\"object\": \"obj\", \"operationParams\": "
+                   "{\"offer\": \"v=0\\r\\n\", \"list\": [1, 2.5e3, true, null]}, "
+                   "\"sessionId\": \"session\"}}") );
+
+  BOOST_CHECK_EQUAL (*envelope.getJsonRpc (), "2.0");
+  BOOST_CHECK_EQUAL (*envelope.getMethod (), "invoke");
+  BOOST_CHECK_EQUAL (*envelope.getId (), "3");
+  BOOST_CHECK_EQUAL (*envelope.getSessionId (), "session");
+  BOOST_CHECK (envelope.hasParams () );
+  BOOST_CHECK (envelope.hasOtherParams () );
+
+  BOOST_REQUIRE (envelope.scan ("{\"id\":2,\"method\":\"keepAlive\","
+                                "\"params\":{\"sessionId\":\"session\"}}") );
+  BOOST_CHECK (envelope.hasParams () );
+  BOOST_CHECK (!envelope.hasOtherParams () );
+
+  BOOST_REQUIRE (envelope.scan ("{\"id\":\"abc\",\"method\":\"ping\"}") );
+  BOOST_CHECK (!envelope.getJsonRpc () );
+  BOOST_CHECK_EQUAL (*envelope.getId (), "abc");
+  BOOST_CHECK (!envelope.getSessionId () );
+  BOOST_CHECK (!envelope.hasParams () );
+  BOOST_CHECK (!envelope.hasOtherParams () );
+
+  /* Flags like objectAliases are lost when building from the envelope */
+  BOOST_REQUIRE (envelope.scan ("{\"id\":1,\"jsonrpc\":\"2.0\",\"method\":"
+                                "\"connect\",\"params\":{\"objectAliases\":true}}") );
+  BOOST_CHECK (!envelope.getSessionId () );
+  BOOST_CHECK (envelope.hasOtherParams () );
+
+  BOOST_REQUIRE (envelope.scan ("{\"id\":1.5,\"method\":\"ping\"}") );
+  BOOST_CHECK (!envelope.getId () );
+}
+
+BOOST_AUTO_TEST_CASE (scan_failures)
+{
+  RequestEnvelope envelope;
+
+  BOOST_CHECK (!envelope.scan ("") );
+  BOOST_CHECK (!envelope.scan ("[1, 2]") );
+  BOOST_CHECK (!envelope.scan ("{\"method\": \"ping\"") );
+  BOOST_CHECK (!envelope.scan ("{\"method\": \"ping\"} trailing") );
+  BOOST_CHECK (!envelope.scan ("{\"method\": \"pi\\u006eg\"}") );
+  BOOST_CHECK (!envelope.scan ("{\"method\": 3}") );
+  BOOST_CHECK (!envelope.scan ("{\"method\": \"ping\", \"params\": [1]}") );
+  BOOST_CHECK (!envelope.scan ("{\"method\": \"ping\", \"params\": {\"a\": tru}}") );
+  BOOST_CHECK (!envelope.scan ("{\"params\": {\"sessionId\": 3}}") );
+  BOOST_CHECK (!envelope.getMethod () );
+}
+
+BOOST_AUTO_TEST_CASE (deep_nesting)
+{
+  RequestEnvelope envelope;
+  std::string nested = "{\"method\": \"ping\", \"params\": {\"a\": ";
+
+  BOOST_REQUIRE (envelope.scan (nested + "[[[1]]]}}") );
+
+  /* Would overflow the stack if skipped recursively without a limit */
+  nested += std::string (200000, '[') + std::string (200000, ']') + "}}";
+  BOOST_CHECK (!envelope.scan (nested) );
+  BOOST_CHECK (!envelope.scan (std::string ("{\"id\": ") +
+                               std::string (2000, '[') + std::string (2000, ']') + "}") );
+}
+
+BOOST_AUTO_TEST_CASE (to_request)
+{
+  RequestEnvelope envelope;
+  Json::Value request;
+
+  BOOST_REQUIRE (envelope.scan ("{\"jsonrpc\": \"2.0\", \"id\": 7, \"method\": "
+                                "\"ping\", \"params\": {\"interval\": 240000, "
+                                "\"sessionId\": \"session\"}}") );
+
+  request = envelope.toRequest ();
+
+  BOOST_CHECK_EQUAL (request["jsonrpc"].asString (), "2.0");
+  BOOST_CHECK_EQUAL (request["method"].asString (), "ping");
+  BOOST_CHECK (request["id"].isInt () );
+  BOOST_CHECK_EQUAL (request["id"].asInt (), 7);
+  BOOST_CHECK_EQUAL (request["params"]["sessionId"].asString (), "session");
+  BOOST_CHECK (!request["params"].isMember ("interval") );
+}
+
+/*
+ * Reports the cost of scanning a large invoke request, like the ones carrying
+ * an SDP offer, compared with parsing it into a Json::Value
+ */
+BOOST_AUTO_TEST_CASE (scan_cost)
+{
+  const int nRequests = 2000;
+  std::string sdp;
+  Json::Value request;
+  Json::FastWriter writer;
+  std::string requestStr;
+  RequestEnvelope envelope;
+  Json::Reader reader;
+
+  for (int i = 0; i < 100; i++) {
+    sdp += "a=candidate:" + std::to_string (i) +
+           " 1 UDP 2013266431 192.168.1.10 50000 typ host\r\n";
+  }
+
+  request["jsonrpc"] = "2.0";
+  request["id"] = 1;
+  request["method"] = "invoke";
+  request["params"]["object"] = "object";
+  request["params"]["operation"] = "processOffer";
+  request["params"]["operationParams"]["offer"] = sdp;
+  request["params"]["sessionId"] = "session";
+  requestStr = writer.write (request);
+
+  Clock::time_point start = Clock::now();
+
+  for (int i = 0; i < nRequests; i++) {
+    BOOST_REQUIRE (envelope.scan (requestStr) );
+  }
+
+  std::chrono::duration<double, std::micro> scanTime = Clock::now() - start;
+
+  start = Clock::now();
+
+  for (int i = 0; i < nRequests; i++) {
+    Json::Value parsed;
+
+    BOOST_REQUIRE (reader.parse (requestStr, parsed) );
+  }
+
+  std::chrono::duration<double, std::micro> parseTime = Clock::now() - start;
+
+  BOOST_TEST_MESSAGE ("Request of " << requestStr.size () << " bytes: scan " <<
+                      scanTime.count() / nRequests << " us, parse " <<
+                      parseTime.count() / nRequests << " us");
+}
@@ -0,0 +1,481 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BaseTest.hpp"
+#include <boost/test/unit_test.hpp>
+
+#include <gst/gst.h>
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#define GST_CAT_DEFAULT server_benchmark
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+#define GST_DEFAULT_NAME "test_server_benchmark"
+
+#define N_REQUESTS 5000
+#define N_LOAD_CONNECTIONS 8
+#define N_LOAD_REQUESTS 2000
+#define N_SLOW_CONNECTIONS 2
+#define N_SLOW_REQUESTS 200
+
+namespace kurento
+{
+
+typedef std::chrono::steady_clock Clock;
+
+/*
+ * A client connection with its own session and io_service, sending invoke
+ * requests one after the other and recording the latency of each one. Slow
+ * connections create and release an endpoint instead.
+ */
+class LoadConnection
+{
+public:
+  LoadConnection (const std::string &uri, int requests, bool slow) : uri (uri),
+    remaining (requests), slow (slow) {};
+
+  /* Blocks until all the requests are answered */
+  void run ();
+
+  const std::vector<double> &getLatencies ()
+  {
+    return latencies;
+  }
+
+  bool hasFailed ()
+  {
+    return failed;
+  }
+
+private:
+  void onOpen (websocketpp::connection_hdl hdl);
+  void onMessage (websocketpp::connection_hdl hdl,
+                  WebSocketClient::message_ptr msg);
+  void send (websocketpp::connection_hdl hdl, const Json::Value &request);
+
+  WebSocketClient client;
+  std::string uri;
+  int remaining;
+  bool slow;
+  int id = 0;
+  bool failed = false;
+  std::string pipeId;
+  std::string sessionId;
+  std::string endpointId;
+  Clock::time_point sent;
+  std::vector<double> latencies;
+  Json::Reader reader;
+  Json::FastWriter writer;
+};
+
+void
+LoadConnection::run ()
+{
+  websocketpp::lib::error_code ec;
+  WebSocketClient::connection_ptr con;
+
+  client.clear_access_channels (websocketpp::log::alevel::all);
+  client.clear_error_channels (websocketpp::log::elevel::all);
+  client.set_open_handler (std::bind (&LoadConnection::onOpen, this,
+                                      std::placeholders::_1) );
+  client.set_message_handler (std::bind (&LoadConnection::onMessage, this,
+                                         std::placeholders::_1, std::placeholders::_2) );
+  client.init_asio();
+
+  con = client.get_connection (uri, ec);
+
+  if (ec) {
+    failed = true;
+    return;
+  }
+
+  client.connect (con);
+  client.run();
+}
+
+void
+LoadConnection::send (websocketpp::connection_hdl hdl,
+                      const Json::Value &request)
+{
+  sent = Clock::now();
+  client.send (hdl, writer.write (request), websocketpp::frame::opcode::text);
+}
+
+void
+LoadConnection::onOpen (websocketpp::connection_hdl hdl)
+{
+  Json::Value request;
+
+  request["jsonrpc"] = "2.0";
+  request["id"] = id++;
+  request["method"] = "create";
+  request["params"]["type"] = "MediaPipeline";
+
+  send (hdl, request);
+}
+
+void
+LoadConnection::onMessage (websocketpp::connection_hdl hdl,
+                           WebSocketClient::message_ptr msg)
+{
+  Json::Value response;
+  Json::Value request;
+
+  if (!reader.parse (msg->get_payload(), response)
+      || !response.isMember ("result") ) {
+    failed = true;
+    client.close (hdl, websocketpp::close::status::normal, "");
+    return;
+  }
+
+  if (pipeId.empty () ) {
+    pipeId = response["result"]["value"].asString();
+    sessionId = response["result"]["sessionId"].asString();
+  } else {
+    latencies.push_back (std::chrono::duration<double, std::micro>
+                         (Clock::now() - sent).count() );
+    remaining--;
+
+    if (slow && endpointId.empty () ) {
+      endpointId = response["result"]["value"].asString();
+    } else if (slow) {
+      endpointId.clear ();
+    }
+  }
+
+  if (remaining == 0) {
+    client.close (hdl, websocketpp::close::status::normal, "");
+    return;
+  }
+
+  request["jsonrpc"] = "2.0";
+  request["id"] = id++;
+  request["params"]["sessionId"] = sessionId;
+
+  if (!slow) {
+    request["method"] = "invoke";
+    request["params"]["object"] = pipeId;
+    request["params"]["operation"] = "getName";
+  } else if (endpointId.empty () ) {
+    request["method"] = "create";
+    request["params"]["type"] = "WebRtcEndpoint";
+    request["params"]["constructorParams"]["mediaPipeline"] = pipeId;
+  } else {
+    request["method"] = "release";
+    request["params"]["object"] = endpointId;
+  }
+
+  send (hdl, request);
+}
+
+class BenchmarkHandler : public F
+{
+public:
+  BenchmarkHandler() : F()
+  {
+    GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, GST_DEFAULT_NAME, 0,
+                             GST_DEFAULT_NAME);
+  };
+
+  virtual ~BenchmarkHandler () {};
+
+protected:
+  double measure (const std::string &name,
+                  std::function<Json::Value ()> createRequest);
+  void measureConcurrent (const std::string &name, int slowConnections);
+
+  void benchmark_ping ();
+  void benchmark_invoke ();
+  void benchmark_hot_object ();
+  void benchmark_cached ();
+};
+
+/*
+ * Sends requests one after the other and reports the requests per second the
+ * server answered. Requests are not pipelined, so this measures the time spent
+ * on each request in the server plus one round trip on localhost.
+ */
+double
+BenchmarkHandler::measure (const std::string &name,
+                           std::function<Json::Value ()> createRequest)
+{
+  Clock::time_point start = Clock::now();
+
+  for (int i = 0; i < N_REQUESTS; i++) {
+    Json::Value response = sendRequest (createRequest () );
+
+    BOOST_REQUIRE (!response.isMember ("error") );
+  }
+
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+  double rate = N_REQUESTS / elapsed.count();
+
+  BOOST_TEST_MESSAGE (name << ": " << rate << " requests/s");
+  GST_INFO ("%s: %f requests/s", name.c_str(), rate);
+
+  return rate;
+}
+
+/*
+ * Sends requests from many connections at the same time, each one waiting for
+ * its previous response, and reports the requests per second and the latency
+ * percentiles of all of them. Slow connections add load creating and
+ * releasing endpoints, their requests are not counted.
+ */
+void
+BenchmarkHandler::measureConcurrent (const std::string &name,
+                                     int slowConnections)
+{
+  std::vector<std::shared_ptr<LoadConnection>> connections;
+  std::vector<std::shared_ptr<LoadConnection>> slow;
+  std::vector<std::thread> threads;
+  std::vector<double> latencies;
+  Clock::time_point start;
+
+  for (int i = 0; i < N_LOAD_CONNECTIONS; i++) {
+    connections.push_back (std::shared_ptr<LoadConnection> (new LoadConnection (
+                             getUri (), N_LOAD_REQUESTS, false) ) );
+  }
+
+  for (int i = 0; i < slowConnections; i++) {
+    slow.push_back (std::shared_ptr<LoadConnection> (new LoadConnection (
+                      getUri (), N_SLOW_REQUESTS, true) ) );
+  }
+
+  start = Clock::now();
+
+  for (std::shared_ptr<LoadConnection> connection : slow) {
+    threads.push_back (std::thread ([connection] () {
+      connection->run ();
+    }) );
+  }
+
+  for (std::shared_ptr<LoadConnection> connection : connections) {
+    threads.push_back (std::thread ([connection] () {
+      connection->run ();
+    }) );
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  for (std::shared_ptr<LoadConnection> connection : slow) {
+    BOOST_REQUIRE (!connection->hasFailed () );
+  }
+
+  for (std::shared_ptr<LoadConnection> connection : connections) {
+    BOOST_REQUIRE (!connection->hasFailed () );
+    latencies.insert (latencies.end(), connection->getLatencies().begin(),
+                      connection->getLatencies().end() );
+  }
+
+  BOOST_REQUIRE (latencies.size() == N_LOAD_CONNECTIONS * N_LOAD_REQUESTS);
+  std::sort (latencies.begin(), latencies.end() );
+
+  double rate = latencies.size() / elapsed.count();
+  double p50 = latencies[latencies.size() / 2];
+  double p99 = latencies[latencies.size() * 99 / 100];
+  double p999 = latencies[latencies.size() * 999 / 1000];
+
+  BOOST_TEST_MESSAGE (name << ": " << rate << " requests/s, latency p50 " <<
+                      p50 << " us, p99 " << p99 << " us, p99.9 " << p999 << " us");
+  GST_INFO ("%s: %f requests/s, latency p50 %f us, p99 %f us, p99.9 %f us",
+            name.c_str(), rate, p50, p99, p999);
+}
+
+void
+BenchmarkHandler::benchmark_ping ()
+{
+  /* Requests without sessionId */
+  measure ("ping", [this] () {
+    Json::Value request;
+
+    request["jsonrpc"] = "2.0";
+    request["id"] = getId();
+    request["method"] = "ping";
+    request["params"]["interval"] = 240000;
+
+    return request;
+  });
+}
+
+void
+BenchmarkHandler::benchmark_invoke ()
+{
+  Json::Value request;
+  Json::Value response;
+  std::string pipeId;
+  std::string sessionId;
+
+  request["jsonrpc"] = "2.0";
+  request["id"] = getId();
+  request["method"] = "create";
+  request["params"]["type"] = "MediaPipeline";
+
+  response = sendRequest (request);
+
+  BOOST_REQUIRE (response.isMember ("result") );
+
+  pipeId = response["result"]["value"].asString();
+  sessionId = response["result"]["sessionId"].asString();
+
+  /* Requests without optional parameters, all of them cache misses */
+  measure ("invoke", [this, pipeId, sessionId] () {
+    Json::Value request;
+
+    request["jsonrpc"] = "2.0";
+    request["id"] = getId();
+    request["method"] = "invoke";
+    request["params"]["object"] = pipeId;
+    request["params"]["operation"] = "getName";
+    request["params"]["sessionId"] = sessionId;
+
+    return request;
+  });
+}
+
+/*
+ * Requests on the same endpoint from one session, as a chatty client calling
+ * getters. The object is found in the session object cache.
+ */
+void
+BenchmarkHandler::benchmark_hot_object ()
+{
+  Json::Value request;
+  Json::Value response;
+  std::string objId;
+  std::string sessionId;
+
+  request["jsonrpc"] = "2.0";
+  request["id"] = getId();
+  request["method"] = "create";
+  request["params"]["type"] = "MediaPipeline";
+
+  response = sendRequest (request);
+
+  BOOST_REQUIRE (response.isMember ("result") );
+
+  sessionId = response["result"]["sessionId"].asString();
+
+  request["id"] = getId();
+  request["params"]["type"] = "WebRtcEndpoint";
+  request["params"]["constructorParams"]["mediaPipeline"] =
+    response["result"]["value"];
+  request["params"]["sessionId"] = sessionId;
+
+  response = sendRequest (request);
+
+  BOOST_REQUIRE (response.isMember ("result") );
+
+  objId = response["result"]["value"].asString();
+
+  measure ("invoke on hot object", [this, objId, sessionId] () {
+    Json::Value request;
+
+    request["jsonrpc"] = "2.0";
+    request["id"] = getId();
+    request["method"] = "invoke";
+    request["params"]["object"] = objId;
+    request["params"]["operation"] = "getName";
+    request["params"]["sessionId"] = sessionId;
+
+    return request;
+  });
+
+  measure ("describe on hot object", [this, objId, sessionId] () {
+    Json::Value request;
+
+    request["jsonrpc"] = "2.0";
+    request["id"] = getId();
+    request["method"] = "describe";
+    request["params"]["object"] = objId;
+    request["params"]["sessionId"] = sessionId;
+
+    return request;
+  });
+}
+
+void
+BenchmarkHandler::benchmark_cached ()
+{
+  Json::Value request;
+
+  request["jsonrpc"] = "2.0";
+  request["id"] = getId();
+  request["method"] = "ping";
+  request["params"]["sessionId"] = "benchmark";
+
+  /* The same request again and again, answered from the request cache */
+  measure ("cached", [request] () {
+    return request;
+  });
+}
+
+BOOST_FIXTURE_TEST_SUITE ( server_benchmark_suite, BenchmarkHandler)
+
+BOOST_AUTO_TEST_CASE ( server_request_rate )
+{
+  start();
+  benchmark_ping ();
+  benchmark_invoke ();
+  benchmark_hot_object ();
+  benchmark_cached ();
+}
+
+/* The same load on both transport modes, to compare them */
+BOOST_AUTO_TEST_CASE ( transport_shared_io_service )
+{
+  setReusePort (false);
+  start();
+  measureConcurrent ("shared io_service", 0);
+}
+
+BOOST_AUTO_TEST_CASE ( transport_reuse_port )
+{
+  setReusePort (true);
+  start();
+  measureConcurrent ("io_service per thread with SO_REUSEPORT", 0);
+}
+
+/*
+ * Fast requests while others create and release endpoints, processed on the
+ * network threads as before the worker pool, and on the pool
+ */
+BOOST_AUTO_TEST_CASE ( mixed_load_inline )
+{
+  setWorkerThreads (0);
+  start();
+  measureConcurrent ("mixed load on network threads", N_SLOW_CONNECTIONS);
+}
+
+BOOST_AUTO_TEST_CASE ( mixed_load_worker_pool )
+{
+  start();
+  measureConcurrent ("mixed load on worker pool", N_SLOW_CONNECTIONS);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* kurento */
@@ -47,6 +47,10 @@ protected:
   void check_connect_call ();
   void check_bad_transaction_call ();
   void check_transaction_call ();
+  void check_failed_transaction_call ();
+  void check_batch_call ();
+  void check_object_aliases ();
+  void check_server_stats ();
 
   void runTests ()
   {
@@ -57,6 +61,10 @@ protected:
     check_create_pipeline_call();
     check_bad_transaction_call();
     check_transaction_call();
+    check_failed_transaction_call();
+    check_batch_call();
+    check_object_aliases();
+    check_server_stats();
   }
 };
 
@@ -79,6 +87,20 @@ ClientHandler::check_error_call()
   BOOST_CHECK (response["error"]["code"].isInt() );
   BOOST_CHECK (response["error"]["code"].asInt() == -32600);
   BOOST_CHECK (response["error"].isMember ("message") );
+
+  /* Names close to the built-in ones must not be taken for them */
+  for (const char *method : {
+         "pong", "crEate", "unknownMethod"
+       }) {
+    request["jsonrpc"] = "2.0";
+    request["id"] = getId();
+    request["method"] = method;
+
+    response = sendRequest (request);
+
+    BOOST_CHECK (response.isMember ("error") );
+    BOOST_CHECK (response["error"]["code"].asInt() == -32601);
+  }
 }
 
 void
@@ -196,6 +218,55 @@ ClientHandler::check_transaction_call()
                Json::ValueType::nullValue);
 }
 
+void
+ClientHandler::check_failed_transaction_call()
+{
+  Json::Value response, request;
+  Json::Reader reader;
+  std::string req_str;
+
+  /* Operations 1, 2 and 3 only depend on 0, but 3 must not run after 2 fails */
+  req_str = "{\"id\":" + std::to_string (getId() ) +
+            ",\"jsonrpc\":\"2.0\",\"method\":\"transaction\",\"params\":{\"operations\":[{\"id\":0,\"jsonrpc\":\"2.0\",\"method\":\"create\",\"params\":{\"constructorParams\":{},\"type\":\"MediaPipeline\"}},{\"id\":1,\"jsonrpc\":\"2.0\",\"method\":\"create\",\"params\":{\"constructorParams\":{\"mediaPipeline\":\"newref:0\"},\"type\":\"WebRtcEndpoint\"}},{\"id\":2,\"jsonrpc\":\"2.0\",\"method\":\"invoke\",\"params\":{\"object\":\"newref:0\",\"operation\":\"unknownOperation\"}},{\"id\":3,\"jsonrpc\":\"2.0\",\"method\":\"create\",\"params\":{\"constructorParams\":{\"mediaPipeline\":\"newref:0\"},\"type\":\"WebRtcEndpoint\"}}],\"sessionId\":\"b2b81900-2902-4417-a552-973911efec4c\"}}";
+
+  BOOST_REQUIRE (reader.parse (req_str, request) );
+  response = sendRequest (request);
+
+  BOOST_CHECK (!response.isMember ("error") );
+  BOOST_REQUIRE (response.isMember ("result") );
+  BOOST_REQUIRE (response["result"]["value"].isArray () );
+  BOOST_REQUIRE_EQUAL (response["result"]["value"].size(), 3u);
+
+  for (int i = 0; i < 3; i++) {
+    BOOST_CHECK_EQUAL (response["result"]["value"][i]["id"].asInt (), i);
+  }
+
+  BOOST_CHECK (response["result"]["value"][1].isMember ("result") );
+  BOOST_CHECK (response["result"]["value"][2].isMember ("error") );
+
+  /*
+   * Endpoints 1 and 2 are created in parallel and connected by 3. Nothing
+   * after the failure of 4 runs, even the create 5 that only depends on 0.
+   */
+  req_str = "{\"id\":" + std::to_string (getId() ) +
+            ",\"jsonrpc\":\"2.0\",\"method\":\"transaction\",\"params\":{\"operations\":[{\"id\":0,\"jsonrpc\":\"2.0\",\"method\":\"create\",\"params\":{\"constructorParams\":{},\"type\":\"MediaPipeline\"}},{\"id\":1,\"jsonrpc\":\"2.0\",\"method\":\"create\",\"params\":{\"constructorParams\":{\"mediaPipeline\":\"newref:0\"},\"type\":\"WebRtcEndpoint\"}},{\"id\":2,\"jsonrpc\":\"2.0\",\"method\":\"create\",\"params\":{\"constructorParams\":{\"mediaPipeline\":\"newref:0\"},\"type\":\"WebRtcEndpoint\"}},{\"id\":3,\"jsonrpc\":\"2.0\",\"method\":\"invoke\",\"params\":{\"object\":\"newref:1\",\"operation\":\"connect\",\"operationParams\":{\"sink\":\"newref:2\"}}},{\"id\":4,\"jsonrpc\":\"2.0\",\"method\":\"invoke\",\"params\":{\"object\":\"newref:0\",\"operation\":\"unknownOperation\"}},{\"id\":5,\"jsonrpc\":\"2.0\",\"method\":\"create\",\"params\":{\"constructorParams\":{\"mediaPipeline\":\"newref:0\"},\"type\":\"WebRtcEndpoint\"}},{\"id\":6,\"jsonrpc\":\"2.0\",\"method\":\"invoke\",\"params\":{\"object\":\"newref:1\",\"operation\":\"getName\"}}],\"sessionId\":\"b2b81900-2902-4417-a552-973911efec4c\"}}";
+
+  BOOST_REQUIRE (reader.parse (req_str, request) );
+  response = sendRequest (request);
+
+  BOOST_CHECK (!response.isMember ("error") );
+  BOOST_REQUIRE (response.isMember ("result") );
+  BOOST_REQUIRE (response["result"]["value"].isArray () );
+  BOOST_REQUIRE_EQUAL (response["result"]["value"].size(), 5u);
+
+  for (int i = 0; i < 4; i++) {
+    BOOST_CHECK_EQUAL (response["result"]["value"][i]["id"].asInt (), i);
+    BOOST_CHECK (response["result"]["value"][i].isMember ("result") );
+  }
+
+  BOOST_CHECK (response["result"]["value"][4].isMember ("error") );
+}
+
 void
 ClientHandler::check_create_pipeline_call()
 {
@@ -307,6 +378,26 @@ ClientHandler::check_create_pipeline_call()
     BOOST_CHECK (hierarchy[i].asString() == expected_hierarchy[i]);
   }
 
+  request["id"] = getId();
+  request["method"] = "describe";
+  params.clear();
+  params["objects"].append (objId);
+  params["objects"].append (pipeId);
+  params["objects"].append ("unknownObject");
+  params["sessionId"] = "12345";
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_CHECK (!response.isMember ("error") );
+  BOOST_REQUIRE (response["result"]["value"].isArray () );
+  BOOST_REQUIRE_EQUAL (response["result"]["value"].size (), 3u);
+  BOOST_CHECK (response["result"]["value"][0]["hierarchy"] == hierarchy);
+  BOOST_CHECK (response["result"]["value"][0]["object"].asString () == objId);
+  BOOST_CHECK (response["result"]["value"][1]["type"].asString () ==
+               "MediaPipeline");
+  BOOST_CHECK (response["result"]["value"][2].isMember ("error") );
+
   std::string sessionId = "123456";
   request.removeMember ("id");
   request["id"] = getId();
@@ -324,6 +415,218 @@ ClientHandler::check_create_pipeline_call()
   BOOST_CHECK (response.isMember ("result") );
   BOOST_CHECK (response["result"].isMember ("sessionId") );
   BOOST_CHECK (response["result"]["sessionId"].asString () == sessionId );
+
+  /* The object was used by both sessions, it must not be found any more */
+  request["id"] = getId();
+  request["method"] = "invoke";
+  params.clear();
+  params["object"] = objId;
+  params["operation"] = "getName";
+  params["sessionId"] = sessionId;
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_CHECK (response.isMember ("error") );
+
+  request["id"] = getId();
+  request["method"] = "describe";
+  params.clear();
+  params["object"] = objId;
+  params["sessionId"] = "12345";
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_CHECK (response.isMember ("error") );
+}
+
+void
+ClientHandler::check_batch_call()
+{
+  Json::Value batch;
+  Json::Value request;
+  Json::Value response;
+  std::vector<int> ids;
+
+  request["jsonrpc"] = "2.0";
+  request["method"] = "ping";
+  request["params"]["interval"] = 240000;
+
+  for (int i = 0; i < 5; i++) {
+    ids.push_back (getId() );
+    request["id"] = ids[i];
+    batch.append (request);
+  }
+
+  /* A notification, not answered */
+  request.removeMember ("id");
+  batch.append (request);
+
+  /* An invalid request, answered with an error */
+  batch.append (1);
+
+  response = sendBatch (batch);
+
+  BOOST_REQUIRE (response.isArray () );
+  BOOST_REQUIRE_EQUAL (response.size (), 6u);
+
+  for (int i = 0; i < 5; i++) {
+    BOOST_CHECK (response[i].isMember ("result") );
+    BOOST_CHECK_EQUAL (response[i]["id"].asInt (), ids[i]);
+    BOOST_CHECK_EQUAL (response[i]["result"]["value"].asString (), "pong");
+  }
+
+  BOOST_CHECK (response[5].isMember ("error") );
+}
+
+void
+ClientHandler::check_object_aliases()
+{
+  Json::Value request;
+  Json::Value response;
+  Json::Value params;
+  std::string sessionId;
+  std::string pipeId;
+  Json::Value alias;
+
+  request["jsonrpc"] = "2.0";
+  request["id"] = getId();
+  request["method"] = "connect";
+  params["objectAliases"] = true;
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_REQUIRE (response.isMember ("result") );
+  BOOST_CHECK (response["result"]["objectAliases"].asBool () );
+  sessionId = response["result"]["sessionId"].asString ();
+
+  /* Reconnecting keeps the flag, not only the sessionId of the params */
+  request["id"] = getId();
+  params["sessionId"] = sessionId;
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_REQUIRE (response.isMember ("result") );
+  BOOST_CHECK (response["result"]["objectAliases"].asBool () );
+  BOOST_CHECK_EQUAL (response["result"]["sessionId"].asString (), sessionId);
+
+  request["id"] = getId();
+  request["method"] = "create";
+  params.clear();
+  params["type"] = "MediaPipeline";
+  params["sessionId"] = sessionId;
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_REQUIRE (response.isMember ("result") );
+  BOOST_REQUIRE (response["result"]["alias"].isUInt () );
+  pipeId = response["result"]["value"].asString ();
+  alias = response["result"]["alias"];
+
+  request["id"] = getId();
+  request["method"] = "invoke";
+  params.clear();
+  params["object"] = alias;
+  params["operation"] = "getName";
+  params["sessionId"] = sessionId;
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_CHECK (!response.isMember ("error") );
+  BOOST_CHECK (response["result"].isMember ("value") );
+
+  request["id"] = getId();
+  request["method"] = "describe";
+  params.clear();
+  params["object"] = pipeId;
+  params["sessionId"] = sessionId;
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_CHECK (response["result"]["alias"] == alias);
+  BOOST_CHECK (response["result"]["type"].asString () == "MediaPipeline");
+
+  /* Objects that are not found do not get an alias */
+  request["id"] = getId();
+  request["method"] = "describe";
+  params.clear();
+  params["objects"].append (pipeId);
+  params["objects"].append ("unknownObject");
+  params["sessionId"] = sessionId;
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_REQUIRE_EQUAL (response["result"]["value"].size (), 2u);
+  BOOST_CHECK (response["result"]["value"][0]["alias"] == alias);
+  BOOST_CHECK (response["result"]["value"][1].isMember ("error") );
+  BOOST_CHECK (!response["result"]["value"][1].isMember ("alias") );
+
+  request["id"] = getId();
+  request["method"] = "release";
+  params.clear();
+  params["object"] = alias;
+  params["sessionId"] = sessionId;
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_CHECK (!response.isMember ("error") );
+
+  /* Aliases of released objects are not valid any more */
+  request["id"] = getId();
+  request["method"] = "invoke";
+  params.clear();
+  params["object"] = alias;
+  params["operation"] = "getName";
+  params["sessionId"] = sessionId;
+  request["params"] = params;
+
+  response = sendRequest (request);
+
+  BOOST_CHECK (response.isMember ("error") );
+}
+
+void
+ClientHandler::check_server_stats()
+{
+  Json::Value request;
+  Json::Value response;
+  Json::Value stats;
+
+  request["jsonrpc"] = "2.0";
+  request["id"] = getId();
+  request["method"] = "getServerStats";
+
+  response = sendRequest (request);
+
+  BOOST_REQUIRE (response.isMember ("result") );
+  stats = response["result"]["value"];
+
+  /* Earlier checks already sent these requests */
+  BOOST_CHECK (stats["methods"]["create"]["count"].asUInt64 () > 0);
+  BOOST_CHECK (stats["methods"]["invoke"]["errors"].asUInt64 () > 0);
+  BOOST_CHECK (stats["methods"]["ping"]["latency"]["count"].asUInt64 () > 0);
+  BOOST_CHECK (stats["methods"]["ping"]["latency"]["p99"].asUInt64 () <=
+               stats["methods"]["ping"]["latency"]["max"].asUInt64 () );
+  BOOST_CHECK (stats["phases"]["parse"]["count"].asUInt64 () > 0);
+  BOOST_CHECK (stats["phases"]["serialize"]["count"].asUInt64 () > 0);
+  BOOST_CHECK (stats["requestCache"].isMember ("hitRatio") );
+  BOOST_CHECK (stats["connections"].asInt () >= 1);
+  BOOST_CHECK (stats["sessions"].isUInt () );
+  BOOST_CHECK (stats["resources"]["threads"].asInt () > 1);
+  BOOST_CHECK (stats["resources"]["openFiles"].asInt () > 0);
+  BOOST_CHECK (stats["resources"]["rssBytes"].asUInt64 () > 0);
+  BOOST_CHECK (stats["compression"].isMember ("ratio") );
+  BOOST_CHECK (stats["writes"]["writes"].asUInt64 () > 0);
+  BOOST_CHECK (stats["writes"]["frames"].asUInt64 () >=
+               stats["writes"]["writes"].asUInt64 () );
 }
 
 BOOST_FIXTURE_TEST_SUITE ( server_json_test, ClientHandler)
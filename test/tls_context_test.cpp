@@ -0,0 +1,155 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE TlsContextCache
+#include <boost/test/unit_test.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "TlsContextCache.hpp"
+
+using namespace kurento;
+
+typedef std::chrono::steady_clock Clock;
+typedef boost::asio::ssl::stream<boost::asio::ip::tcp::socket> SslStream;
+
+static const boost::filesystem::path
+CERTIFICATE_FILE (TEST_DIRECTORY "/testCertificate.pem");
+
+static const int N_HANDSHAKES = 200;
+
+/*
+ * Runs handshakes on localhost, one after the other, and returns how many
+ * were done per second. The server gets the context of each connection from
+ * getContext, the client offers its previous session when resume is set.
+ */
+static double
+measureHandshakes (std::function<TlsContextCache::ContextPtr () > getContext,
+                   bool resume, int &resumed)
+{
+  boost::asio::io_service ios;
+  boost::asio::ip::tcp::acceptor acceptor (ios,
+      boost::asio::ip::tcp::endpoint (boost::asio::ip::address_v4::loopback (), 0) );
+  boost::asio::ip::tcp::endpoint endpoint = acceptor.local_endpoint ();
+  boost::asio::ssl::context clientContext (
+    boost::asio::ssl::context::tlsv12_client);
+  SSL_SESSION *session = NULL;
+  Clock::time_point start;
+
+  resumed = 0;
+
+  std::thread server ([&] () {
+    for (int i = 0; i < N_HANDSHAKES; i++) {
+      TlsContextCache::ContextPtr context = getContext ();
+      SslStream stream (ios, *context);
+      boost::system::error_code ec;
+
+      acceptor.accept (stream.lowest_layer () );
+      stream.handshake (boost::asio::ssl::stream_base::server, ec);
+      BOOST_REQUIRE (!ec);
+      stream.shutdown (ec);
+    }
+  });
+
+  start = Clock::now ();
+
+  for (int i = 0; i < N_HANDSHAKES; i++) {
+    SslStream stream (ios, clientContext);
+    boost::system::error_code ec;
+
+    if (resume && session != NULL) {
+      SSL_set_session (stream.native_handle (), session);
+    }
+
+    stream.lowest_layer ().connect (endpoint);
+    stream.handshake (boost::asio::ssl::stream_base::client, ec);
+    BOOST_REQUIRE (!ec);
+
+    if (SSL_session_reused (stream.native_handle () ) ) {
+      resumed++;
+    }
+
+    if (session != NULL) {
+      SSL_SESSION_free (session);
+    }
+
+    session = SSL_get1_session (stream.native_handle () );
+    stream.shutdown (ec);
+  }
+
+  std::chrono::duration<double> elapsed = Clock::now () - start;
+
+  server.join ();
+
+  if (session != NULL) {
+    SSL_SESSION_free (session);
+  }
+
+  return N_HANDSHAKES / elapsed.count ();
+}
+
+BOOST_AUTO_TEST_CASE (shared_context)
+{
+  TlsContextCache cache (CERTIFICATE_FILE, "", "TLSv1.2");
+
+  BOOST_REQUIRE (cache.get () );
+  BOOST_CHECK (cache.get () == cache.get () );
+  BOOST_CHECK (cache.create () != cache.get () );
+}
+
+BOOST_AUTO_TEST_CASE (invalid_configuration)
+{
+  BOOST_CHECK_THROW (TlsContextCache (CERTIFICATE_FILE, "", "SSLv3"),
+                     std::exception);
+  BOOST_CHECK_THROW (TlsContextCache (boost::filesystem::path (TEST_DIRECTORY) /
+                                      "missing.pem", "", "TLSv1"), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE (benchmark_handshakes)
+{
+  TlsContextCache cache (CERTIFICATE_FILE, "", "TLSv1");
+  int resumed;
+  double rate;
+
+  /* As before, a context loading the certificate for each connection */
+  rate = measureHandshakes ([&cache] () {
+    return cache.create ();
+  }, false, resumed);
+  BOOST_TEST_MESSAGE ("New context per connection: " << rate <<
+                      " handshakes/s");
+
+  rate = measureHandshakes ([&cache] () {
+    return cache.get ();
+  }, false, resumed);
+  BOOST_TEST_MESSAGE ("Shared context, full handshakes: " << rate <<
+                      " handshakes/s");
+  BOOST_CHECK_EQUAL (resumed, 0);
+
+  rate = measureHandshakes ([&cache] () {
+    return cache.get ();
+  }, true, resumed);
+  BOOST_TEST_MESSAGE ("Shared context, resumed sessions: " << rate <<
+                      " handshakes/s");
+  BOOST_CHECK_EQUAL (resumed, N_HANDSHAKES - 1);
+}
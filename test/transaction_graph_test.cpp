@@ -0,0 +1,117 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE TransactionGraph
+#include <boost/test/unit_test.hpp>
+
+#include "TransactionGraph.hpp"
+
+using namespace kurento;
+
+typedef std::vector<std::vector<unsigned int>> Levels;
+
+static Json::Value
+create (const std::string &type, const std::string &pipeline)
+{
+  Json::Value operation;
+
+  operation["method"] = "create";
+  operation["params"]["type"] = type;
+  operation["params"]["sessionId"] = "session";
+
+  if (!pipeline.empty () ) {
+    operation["params"]["constructorParams"]["mediaPipeline"] = pipeline;
+  }
+
+  return operation;
+}
+
+static Json::Value
+invoke (const std::string &object, const std::string &operationName,
+        const std::string &sink)
+{
+  Json::Value operation;
+
+  operation["method"] = "invoke";
+  operation["params"]["object"] = object;
+  operation["params"]["operation"] = operationName;
+  operation["params"]["sessionId"] = "session";
+
+  if (!sink.empty () ) {
+    operation["params"]["operationParams"]["sink"] = sink;
+  }
+
+  return operation;
+}
+
+/* A room setup: endpoints are created in parallel, then connected */
+BOOST_AUTO_TEST_CASE (create_and_connect)
+{
+  Json::Value operations;
+  std::vector<std::vector<unsigned int>> refs = {{}, {0}, {0}, {1, 2}, {1, 2}, {0}};
+  Levels levels;
+
+  operations.append (create ("MediaPipeline", "") );
+  operations.append (create ("WebRtcEndpoint", "newref:0") );
+  operations.append (create ("WebRtcEndpoint", "newref:0") );
+  operations.append (invoke ("newref:1", "connect", "newref:2") );
+  operations.append (invoke ("newref:2", "connect", "newref:1") );
+  /* Same pipeline as the connects, which could change it */
+  operations.append (create ("WebRtcEndpoint", "newref:0") );
+
+  levels = getTransactionLevels (operations, refs);
+
+  BOOST_CHECK (levels == Levels ({{0}, {1, 2}, {3}, {4}, {5}}) );
+}
+
+/* Objects that existed before the transaction are ordered by pipeline */
+BOOST_AUTO_TEST_CASE (existing_objects)
+{
+  Json::Value operations;
+  std::vector<std::vector<unsigned int>> refs (5);
+  Levels levels;
+
+  operations.append (invoke ("pipeA/element1", "setName", "") );
+  operations.append (create ("WebRtcEndpoint", "pipeB") );
+  operations.append (create ("WebRtcEndpoint", "pipeA") );
+  operations.append (create ("WebRtcEndpoint", "pipeB") );
+  operations.append (invoke ("pipeB/element2", "getName", "") );
+
+  levels = getTransactionLevels (operations, refs);
+
+  /*
+   * Creates in pipeB do not wait for the invoke in pipeA, and no operation
+   * other than a create runs before the earlier ones finish
+   */
+  BOOST_CHECK (levels == Levels ({{0, 1, 3}, {2}, {4}}) );
+}
+
+BOOST_AUTO_TEST_CASE (only_creates)
+{
+  Json::Value operations;
+  std::vector<std::vector<unsigned int>> refs = {{}, {}, {0}, {1}};
+  Levels levels;
+
+  operations.append (create ("MediaPipeline", "") );
+  operations.append (create ("MediaPipeline", "") );
+  operations.append (create ("PlayerEndpoint", "newref:0") );
+  operations.append (create ("PlayerEndpoint", "newref:1") );
+
+  levels = getTransactionLevels (operations, refs);
+
+  BOOST_CHECK (levels == Levels ({{0, 1}, {2, 3}}) );
+}
@@ -0,0 +1,361 @@
+/*
+ * (C) Copyright 2017 Kurento (http://kurento.org/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MODULE WorkerPool
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "WorkerPool.hpp"
+
+using namespace kurento;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int SLOW_TASK_MS = 50;
+
+/* Only reached if the pool is broken, so a failing test does not hang */
+static const std::chrono::seconds LATCH_TIMEOUT (10);
+
+class Latch
+{
+public:
+  Latch (int count) : count (count) {}
+
+  void countDown ()
+  {
+    std::unique_lock<std::mutex> lock (mutex);
+
+    if (--count <= 0) {
+      cond.notify_all ();
+    }
+  }
+
+  bool wait ()
+  {
+    std::unique_lock<std::mutex> lock (mutex);
+
+    return cond.wait_for (lock, LATCH_TIMEOUT, [this] () {
+      return count <= 0;
+    });
+  }
+
+private:
+  int count;
+  std::mutex mutex;
+  std::condition_variable cond;
+};
+
+static double
+percentile (std::vector<double> values, double p)
+{
+  if (values.empty () ) {
+    return 0;
+  }
+
+  std::sort (values.begin(), values.end() );
+
+  return values[ (size_t) ( (values.size() - 1) * p)];
+}
+
+BOOST_AUTO_TEST_CASE (run_all_tasks)
+{
+  std::atomic<int> count (0);
+
+  {
+    WorkerPool pool (4);
+
+    for (int i = 0; i < 10000; i++) {
+      pool.post ([&count] () {
+        count++;
+      });
+    }
+
+    pool.stop ();
+  }
+
+  BOOST_CHECK_EQUAL (count, 10000);
+}
+
+BOOST_AUTO_TEST_CASE (nested_tasks)
+{
+  std::atomic<int> count (0);
+  WorkerPool pool (2);
+
+  for (int i = 0; i < 100; i++) {
+    pool.post ([&count, &pool] () {
+      for (int j = 0; j < 10; j++) {
+        pool.post ([&count] () {
+          count++;
+        });
+      }
+    });
+  }
+
+  pool.stop ();
+
+  BOOST_CHECK_EQUAL (count, 1000);
+}
+
+BOOST_AUTO_TEST_CASE (post_after_stop)
+{
+  std::atomic<int> count (0);
+  WorkerPool pool (2);
+
+  pool.stop ();
+  pool.post ([&count] () {
+    count++;
+  });
+
+  for (int i = 0; i < 2; i++) {
+    pool.post ("session", [&count] () {
+      count++;
+    });
+  }
+
+  BOOST_CHECK_EQUAL (count, 0);
+}
+
+BOOST_AUTO_TEST_CASE (strand_order)
+{
+  const int nKeys = 16;
+  const int nTasks = 1000;
+  std::vector<std::vector<int>> results (nKeys);
+  std::atomic<bool> overlapped (false);
+  std::vector<std::unique_ptr<std::atomic<int>>> running;
+  WorkerPool pool (8);
+
+  for (int k = 0; k < nKeys; k++) {
+    running.push_back (std::unique_ptr<std::atomic<int>> (new std::atomic<int>
+                       (0) ) );
+  }
+
+  for (int i = 0; i < nTasks; i++) {
+    for (int k = 0; k < nKeys; k++) {
+      pool.post ("session" + std::to_string (k), [i, k, &results, &running,
+      &overlapped] () {
+        if ( (*running[k]) ++ != 0) {
+          overlapped = true;
+        }
+
+        results[k].push_back (i);
+        (*running[k])--;
+      });
+    }
+  }
+
+  pool.stop ();
+
+  BOOST_CHECK (!overlapped);
+
+  for (int k = 0; k < nKeys; k++) {
+    BOOST_REQUIRE_EQUAL (results[k].size(), (size_t) nTasks);
+
+    for (int i = 0; i < nTasks; i++) {
+      BOOST_CHECK_EQUAL (results[k][i], i);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE (async_strand_order)
+{
+  std::vector<int> results;
+  std::mutex mutex;
+  std::thread completer;
+  std::promise<void> finished;
+  WorkerPool pool (4);
+
+  /* Finishes later from another thread, like a request sent to the media */
+  pool.postAsync ("session", [&] (std::function<void () > done) {
+    completer = std::thread ([&results, &mutex, done] () {
+      std::this_thread::sleep_for (std::chrono::milliseconds (SLOW_TASK_MS) );
+      {
+        std::unique_lock<std::mutex> lock (mutex);
+        results.push_back (1);
+      }
+      done ();
+    });
+  });
+
+  pool.post ("session", [&] () {
+    std::unique_lock<std::mutex> lock (mutex);
+    results.push_back (2);
+  });
+
+  /* A task throwing without calling done does not block the strand */
+  pool.postAsync ("session", [] (std::function<void () > done) {
+    throw std::runtime_error ("failed");
+  });
+
+  pool.post ("session", [&] () {
+    finished.set_value ();
+  });
+
+  finished.get_future ().wait ();
+  completer.join ();
+  pool.stop ();
+
+  BOOST_REQUIRE_EQUAL (results.size (), (size_t) 2);
+  BOOST_CHECK_EQUAL (results[0], 1);
+  BOOST_CHECK_EQUAL (results[1], 2);
+}
+
+BOOST_AUTO_TEST_CASE (worker_thread)
+{
+  std::promise<bool> inWorker;
+  WorkerPool pool (1);
+
+  BOOST_CHECK (!WorkerPool::isWorkerThread () );
+
+  pool.post ([&inWorker] () {
+    inWorker.set_value (WorkerPool::isWorkerThread () );
+  });
+
+  BOOST_CHECK (inWorker.get_future ().get () );
+}
+
+/*
+ * Each task waits for the tasks of the other sessions, so it only finishes if
+ * they run at the same time
+ */
+BOOST_AUTO_TEST_CASE (strand_parallelism)
+{
+  const int nKeys = 4;
+  Latch started (nKeys);
+  std::atomic<int> met (0);
+  WorkerPool pool (nKeys);
+
+  for (int k = 0; k < nKeys; k++) {
+    pool.post ("session" + std::to_string (k), [&started, &met] () {
+      started.countDown ();
+
+      if (started.wait () ) {
+        met++;
+      }
+    });
+  }
+
+  pool.stop ();
+
+  BOOST_CHECK_EQUAL (met, nKeys);
+}
+
+/*
+ * Fast tasks queued behind slow ones must not wait for them while there are
+ * idle workers: the slow tasks are held until every fast task has run.
+ * Reports the p99 latency of the fast tasks.
+ */
+BOOST_AUTO_TEST_CASE (mixed_load_latency)
+{
+  const int nSlow = 4;
+  const int nFast = 2000;
+  std::vector<double> latencies;
+  std::mutex mutex;
+  Latch slowReleased (1);
+  Latch fastDone (nFast);
+  WorkerPool pool (8);
+
+  for (int i = 0; i < nFast; i++) {
+    if (i % (nFast / nSlow) == 0) {
+      pool.post ([&slowReleased] () {
+        slowReleased.wait ();
+      });
+    }
+
+    Clock::time_point queued = Clock::now();
+
+    pool.post ([queued, &latencies, &mutex, &fastDone] () {
+      std::chrono::duration<double, std::milli> elapsed = Clock::now() - queued;
+      std::unique_lock<std::mutex> lock (mutex);
+
+      latencies.push_back (elapsed.count() );
+      lock.unlock ();
+      fastDone.countDown ();
+    });
+  }
+
+  BOOST_CHECK (fastDone.wait () );
+  slowReleased.countDown ();
+  pool.stop ();
+
+  BOOST_REQUIRE_EQUAL (latencies.size(), (size_t) nFast);
+
+  BOOST_TEST_MESSAGE ("Fast task latency p50: " << percentile (latencies, 0.5)
+                      << " ms, p99: " << percentile (latencies, 0.99) << " ms");
+}
+
+/*
+ * Priority tasks run while every worker is blocked, ahead of the keyed tasks
+ * queued before them. Reports the queueing delay of each lane.
+ */
+BOOST_AUTO_TEST_CASE (priority_lane)
+{
+  const int nWorkers = 2;
+  const int nPriority = 100;
+  Latch blocked (nWorkers);
+  Latch released (1);
+  Latch priorityDone (nPriority);
+  WorkerPool pool (nWorkers);
+
+  for (int i = 0; i < nWorkers; i++) {
+    pool.post ("session" + std::to_string (i), [&blocked, &released] () {
+      blocked.countDown ();
+      released.wait ();
+    });
+  }
+
+  BOOST_REQUIRE (blocked.wait () );
+
+  /* Queued behind the blocked tasks of their sessions */
+  for (int i = 0; i < nWorkers; i++) {
+    pool.post ("session" + std::to_string (i), [] () {});
+  }
+
+  for (int i = 0; i < nPriority; i++) {
+    pool.postPriority ([&priorityDone] () {
+      priorityDone.countDown ();
+    });
+  }
+
+  BOOST_CHECK (priorityDone.wait () );
+  released.countDown ();
+  pool.stop ();
+
+  WorkerPool::QueueStats normal = pool.getQueueStats (
+                                    WorkerPool::Lane::NORMAL);
+  WorkerPool::QueueStats priority = pool.getQueueStats (
+                                      WorkerPool::Lane::PRIORITY);
+
+  BOOST_TEST_MESSAGE ("Queueing delay, normal lane: mean " <<
+                      normal.totalDelayUs / normal.tasks << " us, max " <<
+                      normal.maxDelayUs << " us; priority lane: mean " <<
+                      priority.totalDelayUs / priority.tasks << " us, max " <<
+                      priority.maxDelayUs << " us");
+
+  BOOST_CHECK_EQUAL (normal.tasks, (uint64_t) 2 * nWorkers);
+  BOOST_CHECK_EQUAL (priority.tasks, (uint64_t) nPriority);
+  /* The keyed tasks waited until every priority task had run */
+  BOOST_CHECK_LT (priority.maxDelayUs, normal.maxDelayUs);
+}